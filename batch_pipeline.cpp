@@ -0,0 +1,171 @@
+#include "batch_pipeline.hpp"
+#include "bounded_queue.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// Images held by each queue unless set otherwise. It does not grow with the
+// core count, since a queue of large decoded frames can take gigabytes.
+static constexpr int DEFAULT_QUEUE_CAPACITY = 8;
+
+/**
+ * An image on its way through the pipeline
+ */
+struct Frame {
+    size_t index = 0;   // Position in the inputs
+    cv::Mat image;
+};
+
+/**
+ * Decode, detect and encode a list of images in three overlapping stages
+ * Decoder threads read the inputs in order of a shared counter, detector
+ * threads run EdgeDetector::process with a workspace each, and encoder
+ * threads write the edge maps. Detection is the compute-bound stage, so
+ * by default it gets a thread per core and the mostly waiting I/O
+ * threads come on top. With detection.stripes at 0, images below
+ * EdgeDetector::BATCH_SPLIT_PIXELS run on a single stripe of their
+ * detector thread. Larger ones are handed to the shared WorkerPool one at
+ * a time, where their stripes are stolen by idle workers as in
+ * processBatch; cv::parallel_for_ would only split one of several
+ * concurrent images anyway. The stages are joined by bounded lock-free
+ * queues: a stage that runs ahead blocks on a full queue, so at most two
+ * queues of decoded images and edge maps are in memory whatever the
+ * number of inputs, while I/O overlaps compute.
+ *
+ * Images that fail to decode, detect or encode are listed in the stats
+ * and skipped; the other images are still written.
+ *
+ * @param inputs Paths of the images to read
+ * @param outputs Path of the edge map of each input
+ * @param params Detector settings and thread counts
+ * @return Counters and busy time per stage
+ */
+BatchPipelineStats BatchPipeline::run(const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                                      const BatchPipelineParams& params) {
+    if (inputs.size() != outputs.size()) {
+        throw std::runtime_error("BatchPipeline needs one output path per input");
+    }
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int decoders = params.decoders > 0 ? params.decoders : std::max(1, cores / 4);
+    const int encoders = params.encoders > 0 ? params.encoders : std::max(1, cores / 4);
+    const int detectors = params.detectors > 0 ? params.detectors : cores;
+    const size_t capacity = params.queueCapacity > 0 ? params.queueCapacity : DEFAULT_QUEUE_CAPACITY;
+    const int readFlags = params.detection.isColor ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+
+    BoundedQueue<Frame> decoded(capacity);
+    BoundedQueue<Frame> detected(capacity);
+    std::atomic<size_t> nextInput(0);
+    std::atomic<int> decodersLeft(decoders), detectorsLeft(detectors);
+
+    BatchPipelineStats stats;
+    std::mutex statsMutex;
+    auto fail = [&](size_t index, const std::string& reason) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.failures.push_back(inputs[index] + ": " + reason);
+    };
+    auto addBusy = [&](double& total, const cv::TickMeter& busy) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        total += busy.getTimeSec();
+    };
+
+    cv::TickMeter wall;
+    wall.start();
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < decoders; i++) {
+        threads.emplace_back([&] {
+            cv::TickMeter busy;
+            for (size_t index = nextInput++; index < inputs.size(); index = nextInput++) {
+                Frame frame{index, cv::Mat()};
+                std::string error = "could not decode";
+                busy.start();
+                try {
+                    frame.image = cv::imread(inputs[index], readFlags);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+                busy.stop();
+
+                if (frame.image.empty()) fail(index, error);
+                else decoded.push(std::move(frame));
+            }
+            addBusy(stats.decodeSeconds, busy);
+            if (--decodersLeft == 0) decoded.close();
+        });
+    }
+
+    for (int i = 0; i < detectors; i++) {
+        threads.emplace_back([&] {
+            EdgeWorkspace workspace;
+            GradientParams detection = params.detection;
+            cv::TickMeter busy;
+            double megapixels = 0;
+            Frame frame;
+
+            while (decoded.pop(frame)) {
+                Frame result{frame.index, cv::Mat()};
+                busy.start();
+                try {
+                    detection.source = frame.image;
+                    if (params.detection.stripes > 0) {
+                        EdgeDetector::process(detection, result.image, workspace);
+                    } else if (frame.image.total() < EdgeDetector::BATCH_SPLIT_PIXELS) {
+                        detection.stripes = 1;
+                        EdgeDetector::process(detection, result.image, workspace);
+                    } else {
+                        // The pool runs one such call at a time; this thread waits meanwhile
+                        WorkerPool& pool = WorkerPool::shared();
+                        detection.stripes = pool.size();
+                        pool.run(1, [&](int, int) { EdgeDetector::process(detection, result.image, workspace); });
+                    }
+                    megapixels += frame.image.total() / 1e6;
+                } catch (const std::exception& e) {
+                    fail(frame.index, e.what());
+                }
+                busy.stop();
+
+                if (!result.image.empty()) detected.push(std::move(result));
+            }
+            addBusy(stats.detectSeconds, busy);
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats.megapixels += megapixels;
+            }
+            if (--detectorsLeft == 0) detected.close();
+        });
+    }
+
+    for (int i = 0; i < encoders; i++) {
+        threads.emplace_back([&] {
+            cv::TickMeter busy;
+            int processed = 0;
+            Frame frame;
+
+            while (detected.pop(frame)) {
+                bool written = false;
+                std::string error = "could not write " + outputs[frame.index];
+                busy.start();
+                try {
+                    written = cv::imwrite(outputs[frame.index], frame.image);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+                busy.stop();
+
+                if (written) processed++;
+                else fail(frame.index, error);
+            }
+            addBusy(stats.encodeSeconds, busy);
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.processed += processed;
+        });
+    }
+
+    for (std::thread& thread : threads) thread.join();
+    wall.stop();
+    stats.seconds = wall.getTimeSec();
+    return stats;
+}
@@ -0,0 +1,32 @@
+#ifndef BATCH_PIPELINE_HPP
+#define BATCH_PIPELINE_HPP
+
+#include "edge_detector.hpp"
+#include <string>
+#include <vector>
+
+struct BatchPipelineParams {
+    GradientParams detection;       // Detector settings, source is ignored; stripes 0 = by image size
+    int decoders = 0;               // Decoder threads, 0 = a quarter of the cores
+    int detectors = 0;              // Detector threads, 0 = one per core
+    int encoders = 0;               // Encoder threads, 0 = a quarter of the cores
+    int queueCapacity = 0;          // Images between two stages, 0 = eight
+};
+
+struct BatchPipelineStats {
+    int processed = 0;
+    double megapixels = 0;
+    double seconds = 0;             // Wall time
+    double decodeSeconds = 0;       // Busy time summed over the decoder threads
+    double detectSeconds = 0;
+    double encodeSeconds = 0;
+    std::vector<std::string> failures;  // One message per image that was not written
+};
+
+class BatchPipeline {
+public:
+    static BatchPipelineStats run(const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                                  const BatchPipelineParams& params);
+};
+
+#endif // BATCH_PIPELINE_HPP
@@ -0,0 +1,671 @@
+#include "edge_detector.hpp"
+#include "edge_stream.hpp"
+#include "mat_pool_allocator.hpp"
+#include "streaming_hysteresis.hpp"
+#include "tiled_edge_detector.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+namespace fs = std::filesystem;
+
+#define KIDS "kids.bmp"
+
+static constexpr int ITERATIONS = 10;
+
+// Calls of the global operator new, to check that the reused-workspace path
+// allocates nothing on the heap
+static std::atomic<size_t> heapAllocations(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* data = std::malloc(size ? size : 1)) return data;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* data) noexcept {
+    std::free(data);
+}
+
+void operator delete(void* data, size_t) noexcept {
+    std::free(data);
+}
+
+struct EngineInfo {
+    HysteresisEngine engine;
+    const char* name;
+};
+
+static constexpr EngineInfo ENGINES[] = {
+    {HysteresisEngine::Worklist, "worklist"},
+    {HysteresisEngine::UnionFind, "union-find"},
+    {HysteresisEngine::BitParallel, "bit-parallel"},
+};
+
+/**
+ * Build a worst-case hysteresis input: a one pixel wide square spiral of
+ * weak pixels with a one pixel gap between turns, seeded by a single strong
+ * pixel at its centre. The edge has to travel against the scan order on
+ * every turn.
+ *
+ * @param size Width and height of the label map
+ * @return Label map (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+cv::Mat makeSpiral(int size) {
+    cv::Mat labels = cv::Mat::zeros(size, size, CV_8U);
+    auto inside = [size](int x, int y) { return x >= 1 && y >= 1 && x < size - 1 && y < size - 1; };
+    auto free = [&](int x, int y) { return !inside(x, y) || labels.at<uchar>(y, x) == 0; };
+
+    static constexpr int dx[] = {1, 0, -1, 0};
+    static constexpr int dy[] = {0, 1, 0, -1};
+
+    int x = 1, y = 1, dir = 0;
+    labels.at<uchar>(y, x) = EdgeDetector::EDGE_WEAK;
+
+    while (true) {
+        bool moved = false;
+        for (int turn = 0; turn < 2 && !moved; turn++) {
+            int nx = x + dx[dir], ny = y + dy[dir];
+            if (inside(nx, ny) && free(nx, ny) && free(nx + dx[dir], ny + dy[dir])) {
+                x = nx;
+                y = ny;
+                labels.at<uchar>(y, x) = EdgeDetector::EDGE_WEAK;
+                moved = true;
+            } else {
+                dir = (dir + 1) % 4;
+            }
+        }
+        if (!moved) break;
+    }
+
+    labels.at<uchar>(y, x) = EdgeDetector::EDGE_STRONG;
+    return labels;
+}
+
+/**
+ * Reference non-maximum suppression as it was before sector codes: per
+ * pixel .at<>() lookups, a degree conversion and an if/else ladder
+ * @param gradients Magnitude and radian direction
+ * @return Suppressed gradient magnitude
+ */
+cv::Mat ladderSuppression(const GradientResult& gradients) {
+    cv::Mat suppressed = cv::Mat::zeros(gradients.magnitude.size(), CV_32F);
+
+    for (int y = 1; y < gradients.magnitude.rows - 1; y++) {
+        for (int x = 1; x < gradients.magnitude.cols - 1; x++) {
+            float angle = gradients.direction.at<float>(y, x);
+            float angleDeg = angle * 180.0 / CV_PI;
+            if (angleDeg < 0) angleDeg += 180.0;
+
+            float q = 255.0, r = 255.0;
+
+            if ((0 <= angleDeg && angleDeg < 22.5) || (157.5 <= angleDeg && angleDeg <= 180)) {
+                q = gradients.magnitude.at<float>(y, x+1);
+                r = gradients.magnitude.at<float>(y, x-1);
+            }
+            else if (22.5 <= angleDeg && angleDeg < 67.5) {
+                q = gradients.magnitude.at<float>(y+1, x-1);
+                r = gradients.magnitude.at<float>(y-1, x+1);
+            }
+            else if (67.5 <= angleDeg && angleDeg < 112.5) {
+                q = gradients.magnitude.at<float>(y+1, x);
+                r = gradients.magnitude.at<float>(y-1, x);
+            }
+            else if (112.5 <= angleDeg && angleDeg < 157.5) {
+                q = gradients.magnitude.at<float>(y-1, x-1);
+                r = gradients.magnitude.at<float>(y+1, x+1);
+            }
+
+            suppressed.at<float>(y, x) = gradients.magnitude.at<float>(y, x) >= q &&
+                                        gradients.magnitude.at<float>(y, x) >= r ?
+                                        gradients.magnitude.at<float>(y, x) : 0;
+        }
+    }
+    return suppressed;
+}
+
+/**
+ * Pipeline parameters of a benchmark run, the other members at their defaults
+ * @param source Input image
+ * @param sigma Standard deviation for Gaussian kernel
+ * @param lowThreshold Low threshold
+ * @param highThreshold High threshold
+ * @param isColor Flag indicating if the image is color
+ * @return GradientParams
+ */
+GradientParams makeParams(const cv::Mat& source, double sigma, float lowThreshold, float highThreshold, bool isColor) {
+    GradientParams params;
+    params.source = source;
+    params.sigma = sigma;
+    params.lowThreshold = lowThreshold;
+    params.highThreshold = highThreshold;
+    params.isColor = isColor;
+    return params;
+}
+
+/**
+ * Average milliseconds per call of a stage
+ * @param stage Stage to time
+ * @return Average milliseconds per run
+ */
+double timeStage(const std::function<void()>& stage) {
+    double total = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        cv::TickMeter timer;
+        timer.start();
+        stage();
+        timer.stop();
+        total += timer.getTimeMilli();
+    }
+    return total / ITERATIONS;
+}
+
+/**
+ * Time one hysteresis engine on a label map
+ * @param labels Input label map, left untouched
+ * @param engine Hysteresis implementation to time
+ * @return Average milliseconds per run
+ */
+double timeEngine(const cv::Mat& labels, HysteresisEngine engine) {
+    double total = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        cv::Mat work = labels.clone();
+        cv::TickMeter timer;
+        timer.start();
+        EdgeDetector::trackEdges(work, engine);
+        timer.stop();
+        total += timer.getTimeMilli();
+    }
+    return total / ITERATIONS;
+}
+
+/**
+ * Print timings of every engine for one input and check they agree
+ * @param name Input description
+ * @param labels Input label map
+ */
+void reportHysteresis(const std::string& name, const cv::Mat& labels) {
+    cv::Mat reference = labels.clone();
+    EdgeDetector::trackEdges(reference, HysteresisEngine::Worklist);
+
+    double megapixels = labels.total() / 1e6;
+    std::cout << name << " (" << labels.cols << "x" << labels.rows << ")" << std::endl;
+
+    for (const auto& info : ENGINES) {
+        cv::Mat result = labels.clone();
+        EdgeDetector::trackEdges(result, info.engine);
+        bool identical = cv::norm(result, reference, cv::NORM_INF) == 0;
+
+        double ms = timeEngine(labels, info.engine);
+        std::cout << "  " << std::left << std::setw(14) << info.name
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(10) << ms << " ms"
+                  << std::setw(10) << std::setprecision(1) << megapixels / (ms / 1000.0) << " MP/s"
+                  << (identical ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+/**
+ * Print non-maximum suppression timings per megapixel
+ * @param name Input description
+ * @param image Input image
+ * @param isColor Flag indicating if the image is color
+ */
+void reportSuppression(const std::string& name, const cv::Mat& image, bool isColor) {
+    cv::Mat blurred = EdgeDetector::applyGaussianBlur(image, 0.4);
+    GradientResult radians = EdgeDetector::computeGradients(blurred, isColor, DirectionEncoding::Radians);
+    GradientResult sectors = EdgeDetector::computeGradients(blurred, isColor, DirectionEncoding::Sector);
+
+    cv::Mat reference = ladderSuppression(radians);
+    int differing = cv::countNonZero(EdgeDetector::applySuppression(sectors) != reference);
+
+    double megapixels = image.total() / 1e6;
+    double ladderMs = timeStage([&] { ladderSuppression(radians); });
+    double sectorMs = timeStage([&] { EdgeDetector::applySuppression(sectors); });
+
+    std::cout << name << " (" << image.cols << "x" << image.rows << ")" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "ladder"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << ladderMs / megapixels
+              << " ms/MP" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "sector simd"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << sectorMs / megapixels
+              << " ms/MP" << std::setw(10) << std::setprecision(2) << ladderMs / sectorMs << "x"
+              << "  (" << differing << " pixels differ)" << std::endl;
+}
+
+/**
+ * Print full pipeline timings for a doubling number of row stripes
+ * @param name Input description
+ * @param params Pipeline parameters, stripes is overridden
+ */
+void reportStripes(const std::string& name, GradientParams params) {
+    params.stripes = 1;
+    cv::Mat reference = EdgeDetector::process(params);
+    double serialMs = timeStage([&] { EdgeDetector::process(params); });
+
+    std::cout << name << " (" << params.source.cols << "x" << params.source.rows << ")" << std::endl;
+    for (int stripes = 1; stripes <= std::max(1, cv::getNumThreads()); stripes *= 2) {
+        params.stripes = stripes;
+        bool identical = cv::norm(EdgeDetector::process(params), reference, cv::NORM_INF) == 0;
+        double ms = stripes == 1 ? serialMs : timeStage([&] { EdgeDetector::process(params); });
+
+        std::cout << "  " << std::setw(3) << stripes << " stripes"
+                  << std::fixed << std::setprecision(3) << std::setw(12) << ms << " ms"
+                  << std::setw(10) << std::setprecision(2) << serialMs / ms << "x"
+                  << (identical ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+/**
+ * Print stage-at-a-time against tiled timings and the bytes of full-size
+ * intermediates each mode hands between stages, per megapixel
+ * @param name Input description
+ * @param params Pipeline parameters, tiled is overridden
+ */
+void reportTiling(const std::string& name, GradientParams params) {
+    double megapixels = params.source.total() / 1e6;
+    std::cout << name << " (" << params.source.cols << "x" << params.source.rows << ")" << std::endl;
+
+    cv::Mat reference;
+    double untiledBytes = 0;
+    for (bool tiled : {false, true}) {
+        PipelineStats stats;
+        params.tiled = tiled;
+        params.stats = &stats;
+        cv::Mat edges = EdgeDetector::process(params);
+        if (!tiled) reference = edges;
+        bool identical = cv::norm(edges, reference, cv::NORM_INF) == 0;
+
+        double bytesPerMP = stats.intermediateBytes / megapixels;
+        if (!tiled) untiledBytes = bytesPerMP;
+
+        params.stats = nullptr;
+        double ms = timeStage([&] { EdgeDetector::process(params); });
+
+        std::cout << "  " << std::left << std::setw(14) << (tiled ? "tiled" : "stage by stage")
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(10) << ms / megapixels << " ms/MP"
+                  << std::setw(10) << std::setprecision(2) << bytesPerMP / (1 << 20) << " MB/MP";
+        if (tiled) {
+            std::cout << "  saved " << (untiledBytes - bytesPerMP) / (1 << 20) << " MB/MP, "
+                      << stats.tileBytes / 1024 << " KB per tile";
+        }
+        std::cout << (identical ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+/**
+ * Print streaming timings and row buffer size against the whole-image path
+ * @param name Input description
+ * @param params Pipeline parameters
+ */
+void reportStreaming(const std::string& name, GradientParams params) {
+    PipelineStats stats;
+    params.stats = &stats;
+    cv::Mat reference = EdgeDetector::suppress(params);
+    params.stats = nullptr;
+
+    const cv::Mat& source = params.source;
+    cv::Mat streamed(source.size(), CV_32F);
+    size_t bufferBytes = 0;
+    auto stream = [&] {
+        EdgeStream edgeStream(source.size(), source.type(), params.sigma, params.isColor,
+                              [&](int y, const cv::Mat& row) {
+                                  cv::Mat dst = streamed.row(y);
+                                  row.copyTo(dst);
+                              });
+        for (int y = 0; y < source.rows; y++) edgeStream.push(source.row(y));
+        bufferBytes = edgeStream.bufferBytes();
+    };
+
+    stream();
+    bool identical = cv::norm(streamed, reference, cv::NORM_INF) == 0;
+    double wholeMs = timeStage([&] { EdgeDetector::suppress(params); });
+    double streamMs = timeStage(stream);
+
+    std::cout << name << " (" << source.cols << "x" << source.rows << ")" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "whole image"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << wholeMs << " ms"
+              << std::setw(10) << std::setprecision(2) << stats.intermediateBytes / double(1 << 20) << " MB"
+              << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "streaming"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << streamMs << " ms"
+              << std::setw(10) << std::setprecision(2) << bufferBytes / double(1 << 20) << " MB"
+              << (identical ? "" : "  MISMATCH") << std::endl;
+}
+
+/**
+ * Print timings of the fully streamed detector, EdgeStream feeding
+ * StreamingHysteresis, against the whole-image pipeline
+ * @param name Input description
+ * @param params Pipeline parameters with absolute thresholds
+ */
+void reportStreamingHysteresis(const std::string& name, const GradientParams& params) {
+    cv::Mat reference = EdgeDetector::process(params);
+
+    const cv::Mat& source = params.source;
+    cv::Mat streamed(source.size(), CV_8U);
+    int maxPending = 0;
+    auto stream = [&] {
+        StreamingHysteresis hysteresis(source.size(), params.lowThreshold, params.highThreshold,
+                                       [&](int y, const cv::Mat& row) {
+                                           cv::Mat dst = streamed.row(y);
+                                           row.copyTo(dst);
+                                       });
+        EdgeStream edgeStream(source.size(), source.type(), params.sigma, params.isColor,
+                              [&](int, const cv::Mat& row) { hysteresis.push(row); });
+        for (int y = 0; y < source.rows; y++) edgeStream.push(source.row(y));
+        maxPending = hysteresis.maxPendingRows();
+    };
+
+    stream();
+    bool identical = cv::norm(streamed, reference, cv::NORM_INF) == 0;
+    double wholeMs = timeStage([&] { EdgeDetector::process(params); });
+    double streamMs = timeStage(stream);
+
+    std::cout << name << " (" << source.cols << "x" << source.rows << ")" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "whole image"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << wholeMs << " ms" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "streaming"
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << streamMs << " ms"
+              << std::setw(8) << maxPending << " rows max latency" << (identical ? "" : "  MISMATCH") << std::endl;
+}
+
+/**
+ * Print out-of-core timings for several tile sizes
+ * The image is written to a temporary PPM, edges are detected tile by tile
+ * from disk into a temporary PGM and compared with the in-memory result.
+ *
+ * @param name Input description
+ * @param params Pipeline parameters for the in-memory reference
+ */
+void reportOutOfCore(const std::string& name, const GradientParams& params) {
+    fs::path input = fs::temp_directory_path() / "edge_benchmark_input.ppm";
+    fs::path output = fs::temp_directory_path() / "edge_benchmark_edges.pgm";
+
+    const cv::Mat& source = params.source;
+    const cv::Rect whole(cv::Point(), source.size());
+    RasterFile::createPnm(input.string(), source.size(), source.type())->write(whole, source);
+    cv::Mat reference = EdgeDetector::process(params);
+
+    std::cout << name << " (" << source.cols << "x" << source.rows << ")" << std::endl;
+    for (int tileSize : {256, 1024}) {
+        TiledParams tiledParams;
+        tiledParams.sigma = params.sigma;
+        tiledParams.lowThreshold = params.lowThreshold;
+        tiledParams.highThreshold = params.highThreshold;
+        tiledParams.isColor = params.isColor;
+        tiledParams.tileSize = tileSize;
+
+        TiledStats stats;
+        cv::TickMeter timer;
+        timer.start();
+        {
+            auto reader = RasterFile::openPnm(input.string());
+            auto writer = RasterFile::createPnm(output.string(), source.size(), CV_8UC1);
+            stats = TiledEdgeDetector::process(*reader, *writer, tiledParams);
+        }
+        timer.stop();
+
+        cv::Mat edges = RasterFile::openPnm(output.string())->read(whole);
+        bool identical = cv::norm(edges, reference, cv::NORM_INF) == 0;
+
+        std::cout << "  tile " << std::setw(5) << tileSize
+                  << std::fixed << std::setprecision(3) << std::setw(12) << timer.getTimeMilli() << " ms"
+                  << std::setw(6) << stats.tiles << " tiles" << std::setw(4) << stats.hysteresisSweeps << " sweeps"
+                  << std::setw(6) << stats.tileVisits << " visits" << (identical ? "" : "  MISMATCH") << std::endl;
+    }
+
+    fs::remove(input);
+    fs::remove(output);
+}
+
+/**
+ * Print per-call timings of process with fresh buffers against a reused
+ * workspace and output Mat, and the operator new calls of a reused call;
+ * those left come from the cv::parallel_for_ backend, not the pipeline
+ * @param name Input description
+ * @param params Pipeline parameters
+ */
+void reportWorkspace(const std::string& name, const GradientParams& params) {
+    cv::Mat reference = EdgeDetector::process(params);
+    double freshMs = timeStage([&] { EdgeDetector::process(params); });
+
+    EdgeWorkspace workspace;
+    cv::Mat edges;
+    EdgeDetector::process(params, edges, workspace);
+    bool identical = cv::norm(edges, reference, cv::NORM_INF) == 0;
+    double reusedMs = timeStage([&] { EdgeDetector::process(params, edges, workspace); });
+
+    size_t allocationsBefore = heapAllocations.load();
+    for (int i = 0; i < ITERATIONS; i++) EdgeDetector::process(params, edges, workspace);
+    double allocations = static_cast<double>(heapAllocations.load() - allocationsBefore) / ITERATIONS;
+
+    std::cout << name << " (" << params.source.cols << "x" << params.source.rows << ")"
+              << std::fixed << std::setprecision(3)
+              << "  fresh " << freshMs << " ms, workspace " << reusedMs << " ms"
+              << std::setprecision(2) << std::setw(8) << freshMs / reusedMs << "x"
+              << std::setprecision(1) << ", " << allocations << " operator new per call"
+              << (identical ? "" : "  MISMATCH") << std::endl;
+}
+
+/**
+ * Print timings of a sequence of frames of varying sizes with fresh
+ * intermediates from OpenCV's allocator against the pooled allocator
+ * @param name Input description
+ * @param frames Frames processed in turn
+ * @param params Pipeline parameters, source is overridden
+ */
+void reportMatPool(const std::string& name, const std::vector<cv::Mat>& frames, GradientParams params) {
+    std::vector<cv::Mat> edges(frames.size());
+    auto runFrames = [&] {
+        for (size_t i = 0; i < frames.size(); i++) {
+            params.source = frames[i];
+            edges[i] = EdgeDetector::process(params);
+        }
+    };
+
+    double defaultMs = timeStage(runFrames);
+    std::vector<cv::Mat> reference = edges;
+
+    MatPoolAllocator pool;
+    EdgeDetector::setIntermediateAllocator(&pool);
+    double pooledMs = timeStage(runFrames);
+    EdgeDetector::setIntermediateAllocator(nullptr);
+    bool identical = true;
+    for (size_t i = 0; i < frames.size(); i++) identical &= cv::norm(edges[i], reference[i], cv::NORM_INF) == 0;
+
+    MatPoolStats stats = pool.stats();
+    std::cout << name << " (" << frames.size() << " frame sizes)" << std::fixed << std::setprecision(3)
+              << "  default " << defaultMs << " ms, pooled " << pooledMs << " ms"
+              << std::setprecision(2) << std::setw(8) << defaultMs / pooledMs << "x"
+              << "  hits " << stats.hits << ", misses " << stats.misses
+              << ", huge pages " << stats.hugePageBytes / (1 << 20) << " MB"
+              << (identical ? "" : "  MISMATCH") << std::endl;
+}
+
+/**
+ * Print throughput of one process call per image against processBatch,
+ * and the utilization of each pool worker over one batch
+ * @param name Input description
+ * @param batch Parameters of each image
+ */
+void reportBatch(const std::string& name, const std::vector<GradientParams>& batch) {
+    std::vector<cv::Mat> reference;
+    for (const GradientParams& params : batch) reference.push_back(EdgeDetector::process(params));
+    PoolStats pool;
+    std::vector<cv::Mat> results = EdgeDetector::processBatch(batch, &pool);
+    bool identical = true;
+    for (size_t i = 0; i < batch.size(); i++) identical &= cv::norm(results[i], reference[i], cv::NORM_INF) == 0;
+
+    double serialMs = timeStage([&] {
+        for (const GradientParams& params : batch) EdgeDetector::process(params);
+    });
+    double batchMs = timeStage([&] { EdgeDetector::processBatch(batch); });
+
+    std::cout << name << " (" << batch.size() << " images)" << std::fixed << std::setprecision(1)
+              << "  one by one " << batch.size() * 1000 / serialMs << " images/s"
+              << ", batch " << batch.size() * 1000 / batchMs << " images/s"
+              << std::setprecision(2) << std::setw(8) << serialMs / batchMs << "x"
+              << (identical ? "" : "  MISMATCH") << std::endl;
+
+    int steals = 0;
+    std::cout << "  worker utilization" << std::setprecision(0);
+    for (const WorkerStats& worker : pool.workers) {
+        std::cout << " " << (pool.seconds > 0 ? 100 * worker.busySeconds / pool.seconds : 0) << "%";
+        steals += worker.steals;
+    }
+    std::cout << ", " << steals << " steals" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        fs::path imagePath = argc > 1 ? fs::path(argv[1])
+                                      : fs::current_path().parent_path() / "images" / KIDS;
+
+        cv::Mat image = cv::imread(imagePath.string(), cv::IMREAD_COLOR);
+        if (image.empty()) {
+            std::cerr << "Could not open or find the image: " << imagePath << std::endl;
+            return -1;
+        }
+
+        cv::Mat gray;
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+
+        std::cout << "Hysteresis engines, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            GradientParams params = makeParams(isColor ? image : gray, 0.4, 0.05f, 0.15f, isColor);
+
+            cv::Mat suppressed = EdgeDetector::suppress(params);
+            cv::Mat labels = EdgeDetector::classifyEdges(suppressed, params.lowThreshold, params.highThreshold);
+            reportHysteresis(imagePath.filename().string() + (isColor ? " color" : " gray"), labels);
+        }
+
+        for (int size : {512, 2048}) {
+            reportHysteresis("spiral", makeSpiral(size));
+        }
+
+        std::cout << std::endl << "Non-maximum suppression, average of " << ITERATIONS << " runs" << std::endl;
+
+        cv::Mat large;
+        cv::resize(image, large, cv::Size(), 4, 4, cv::INTER_LINEAR);
+        for (const cv::Mat& input : {image, large}) {
+            cv::Mat inputGray;
+            cv::cvtColor(input, inputGray, cv::COLOR_BGR2GRAY);
+            reportSuppression(imagePath.filename().string() + " gray", inputGray, false);
+            reportSuppression(imagePath.filename().string() + " color", input, true);
+        }
+
+        std::cout << std::endl << "Stripe-parallel process, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            cv::Mat largeGray;
+            cv::cvtColor(large, largeGray, cv::COLOR_BGR2GRAY);
+            GradientParams params = makeParams(isColor ? large : largeGray, 1.0, 0.05f, 0.15f, isColor);
+            params.hysteresis = HysteresisEngine::UnionFind;
+            params.fuseClassification = true;
+            reportStripes(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+        }
+
+        std::cout << std::endl << "Tiled pipeline, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            cv::Mat largeGray;
+            cv::cvtColor(large, largeGray, cv::COLOR_BGR2GRAY);
+            GradientParams params = makeParams(isColor ? large : largeGray, 1.0, 0.05f, 0.15f, isColor);
+            params.hysteresis = HysteresisEngine::UnionFind;
+            reportTiling(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+        }
+
+        std::cout << std::endl << "Streaming suppression, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            cv::Mat largeGray;
+            cv::cvtColor(large, largeGray, cv::COLOR_BGR2GRAY);
+            GradientParams params = makeParams(isColor ? large : largeGray, 1.0, 0.05f, 0.15f, isColor);
+            params.stripes = 1;
+            reportStreaming(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+        }
+
+        std::cout << std::endl << "Streaming hysteresis, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            cv::Mat largeGray;
+            cv::cvtColor(large, largeGray, cv::COLOR_BGR2GRAY);
+            GradientParams params = makeParams(isColor ? large : largeGray, 1.0, 20.f, 60.f, isColor);
+            params.thresholdMode = ThresholdMode::Absolute;
+            params.stripes = 1;
+            reportStreamingHysteresis(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+        }
+
+        std::cout << std::endl << "Out-of-core tiles" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            cv::Mat largeGray;
+            cv::cvtColor(large, largeGray, cv::COLOR_BGR2GRAY);
+            GradientParams params = makeParams(isColor ? large : largeGray, 1.0, 0.05f, 0.15f, isColor);
+            reportOutOfCore(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+        }
+
+        std::cout << std::endl << "Reused workspace, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (const cv::Mat& input : {image, large}) {
+            for (bool isColor : {false, true}) {
+                cv::Mat inputGray;
+                cv::cvtColor(input, inputGray, cv::COLOR_BGR2GRAY);
+                GradientParams params = makeParams(isColor ? input : inputGray, 0.4, 0.05f, 0.15f, isColor);
+                reportWorkspace(imagePath.filename().string() + (isColor ? " color" : " gray"), params);
+            }
+        }
+
+        std::cout << std::endl << "Pooled intermediates, average of " << ITERATIONS << " runs" << std::endl;
+
+        for (bool isColor : {false, true}) {
+            std::vector<cv::Mat> frames;
+            for (double scale : {1.0, 0.9, 0.75, 0.5}) {
+                cv::Mat frame;
+                cv::resize(large, frame, cv::Size(), scale, scale, cv::INTER_LINEAR);
+                if (!isColor) cv::cvtColor(frame, frame, cv::COLOR_BGR2GRAY);
+                frames.push_back(frame);
+            }
+            GradientParams params = makeParams(cv::Mat(), 1.0, 0.05f, 0.15f, isColor);
+            reportMatPool(imagePath.filename().string() + (isColor ? " color" : " gray"), frames, params);
+        }
+
+        std::cout << std::endl << "Batch processing, average of " << ITERATIONS << " runs" << std::endl;
+
+        // Up to 0.25, 1 and 4 times the input; the last one reaches past
+        // EdgeDetector::BATCH_SPLIT_PIXELS, so the split path is measured too
+        for (double scale : {0.25, 1.0, 4.0}) {
+            std::vector<GradientParams> batch;
+            for (int i = 0; i < 64; i++) {
+                cv::Mat frame;
+                cv::resize(image, frame, cv::Size(), scale * (1 + i % 4) / 4, scale * (1 + i % 4) / 4);
+                bool isColor = i % 2 == 1;
+                if (!isColor) cv::cvtColor(frame, frame, cv::COLOR_BGR2GRAY);
+                batch.push_back(makeParams(frame, 1.0, 0.05f, 0.15f, isColor));
+            }
+            reportBatch(imagePath.filename().string() + " x" + std::to_string(scale).substr(0, 4), batch);
+        }
+
+        // A few images above EdgeDetector::BATCH_SPLIT_PIXELS among
+        // thumbnails, the case the stealable stripes are for
+        std::vector<GradientParams> mixed;
+        for (int i = 0; i < 64; i++) {
+            cv::Mat frame;
+            if (i % 16 == 0) frame = large;
+            else cv::resize(image, frame, cv::Size(), 0.125, 0.125);
+            mixed.push_back(makeParams(frame, 1.0, 0.05f, 0.15f, true));
+        }
+        reportBatch(imagePath.filename().string() + " mixed", mixed);
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
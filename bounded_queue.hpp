@@ -0,0 +1,150 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+// Bounded multi-producer multi-consumer queue on a ring of sequenced
+// cells (Vyukov). tryPush and tryPop are lock-free; push and pop wait with
+// backoff, which is what bounds the work in flight between two stages.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    bool tryPush(T& value);
+    bool tryPop(T& value);
+    void push(T value);
+    bool pop(T& value);
+    void close();
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static void backoff(int& attempt);
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+    alignas(64) std::atomic<bool> closed{false};
+};
+
+/**
+ * @param capacity Items the queue holds at most, rounded up to a power of two
+ */
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+/**
+ * Append an item if there is room
+ * @param value Item, moved from on success
+ * @return False when the queue is full
+ */
+template<typename T>
+bool BoundedQueue<T>::tryPush(T& value) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Take the oldest item if there is one
+ * @param value Receives the item
+ * @return False when the queue is empty
+ */
+template<typename T>
+bool BoundedQueue<T>::tryPop(T& value) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.value = T();
+                cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Spin, then yield, then sleep, so an idle stage does not hold a core
+ * @param attempt Failed attempts so far, incremented
+ */
+template<typename T>
+void BoundedQueue<T>::backoff(int& attempt) {
+    if (attempt < 64) {
+        attempt++;
+    } else if (attempt < 128) {
+        attempt++;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+/**
+ * Append an item, waiting while the queue is full
+ * @param value Item
+ */
+template<typename T>
+void BoundedQueue<T>::push(T value) {
+    for (int attempt = 0; !tryPush(value);) backoff(attempt);
+}
+
+/**
+ * Take the oldest item, waiting while the queue is empty and open
+ * @param value Receives the item
+ * @return False once the queue is closed and drained
+ */
+template<typename T>
+bool BoundedQueue<T>::pop(T& value) {
+    for (int attempt = 0;; backoff(attempt)) {
+        if (tryPop(value)) return true;
+        if (closed.load(std::memory_order_acquire)) return tryPop(value);
+    }
+}
+
+/**
+ * Mark the end of the input; call after the last push
+ */
+template<typename T>
+void BoundedQueue<T>::close() {
+    closed.store(true, std::memory_order_release);
+}
+
+#endif // BOUNDED_QUEUE_HPP
@@ -1,5 +1,13 @@
 #include "edge_detector.hpp"
+#include "worker_pool.hpp"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
 #include <cmath>
+#include <memory>
+#include <numeric>
 
 /**
  * Calculate Gaussian kernel size based on sigma
@@ -15,230 +23,1417 @@ int EdgeDetector::calculateGaussianKernelSize(double sigma) {
     return std::max(3, static_cast<int>(6 * sigma + 1) | 1);
 }
 
+// Scratch budget of one tile in the tiled pipeline, half of a typical
+// per-core L2 so the source rows and the output stay resident as well.
+static constexpr size_t L2_TILE_BYTES = 256 * 1024;
+
+/**
+ * Bytes held by a Mat's pixels
+ * @param mat Matrix
+ * @return Pixel bytes, 0 for an empty Mat
+ */
+size_t matBytes(const cv::Mat& mat) {
+    return mat.total() * mat.elemSize();
+}
+
+/**
+ * Resolve the number of row stripes a stage is split into
+ * @param stripes Requested stripes, 0 for one per OpenCV thread
+ * @return At least one stripe
+ */
+int EdgeDetector::resolveStripes(int stripes) {
+    return stripes > 0 ? stripes : std::max(1, cv::getNumThreads());
+}
+
+/**
+ * Raise a maximum shared between stripes
+ * @param target Shared maximum
+ * @param value Candidate value
+ */
+void atomicMax(std::atomic<float>& target, float value) {
+    float current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Loop body calling a stage lambda by reference, so running a stage does
+ * not copy its captures into a heap-allocated std::function
+ */
+template<typename Body>
+class StripeBody : public cv::ParallelLoopBody {
+public:
+    explicit StripeBody(const Body& body) : body(body) {}
+    void operator()(const cv::Range& range) const override { body(range); }
+
+private:
+    const Body& body;
+};
+
+/**
+ * Run the stripes of a stage in parallel
+ * On a WorkerPool worker the stripes are forked onto its deque, where idle
+ * workers of a batch steal them; anywhere else they run under
+ * cv::parallel_for_. A single stripe runs inline: going through
+ * cv::parallel_for_ would hold OpenCV's process-wide nested-region flag
+ * for the whole stage and serialise every other thread's parallel loops.
+ *
+ * @param range Range to split
+ * @param body Called once per stripe with its sub-range
+ * @param stripes Number of stripes
+ */
+template<typename Body>
+void parallelStripes(const cv::Range& range, const Body& body, int stripes) {
+    if (stripes <= 1) {
+        if (!range.empty()) body(range);
+        return;
+    }
+
+    StripeBody<Body> loop(body);
+    if (WorkerPool* pool = WorkerPool::current()) pool->parallelFor(range, loop, stripes);
+    else cv::parallel_for_(range, loop, stripes);
+}
+
+// Allocator of the pipeline intermediates, nullptr for OpenCV's default
+static std::atomic<cv::MatAllocator*> intermediateAllocator(nullptr);
+
+/**
+ * Route the intermediate Mats of the pipeline through an allocator
+ * Only buffers that stay inside a workspace are intermediates. Suppressed
+ * maps, label maps, edge maps and the results of the entry points without
+ * a workspace come from OpenCV's default allocator, so callers may keep
+ * them after the allocator is uninstalled. Existing workspace Mats switch
+ * over the next time their size changes.
+ *
+ * @param allocator Allocator outliving every Mat it serves, nullptr for OpenCV's default
+ */
+void EdgeDetector::setIntermediateAllocator(cv::MatAllocator* allocator) {
+    intermediateAllocator.store(allocator);
+}
+
+/**
+ * Create an intermediate Mat
+ * A Mat that already has the size and type is kept; any other is
+ * reallocated from the intermediate allocator.
+ *
+ * @param mat Mat to create
+ * @param rows Rows
+ * @param cols Columns
+ * @param type Element type
+ */
+void createIntermediate(cv::Mat& mat, int rows, int cols, int type) {
+    if (mat.data && mat.rows == rows && mat.cols == cols && mat.type() == type) return;
+    mat.release();
+    mat.allocator = intermediateAllocator.load(std::memory_order_relaxed);
+    mat.create(rows, cols, type);
+}
+
+/**
+ * Create a Mat that is handed to the caller
+ * A Mat that already has the size and type and comes from OpenCV's default
+ * allocator is kept; any other is reallocated from the default allocator.
+ *
+ * @param mat Mat to create
+ * @param rows Rows
+ * @param cols Columns
+ * @param type Element type
+ */
+void createOutput(cv::Mat& mat, int rows, int cols, int type) {
+    if (mat.allocator) {
+        mat.release();
+        mat.allocator = nullptr;
+    }
+    mat.create(rows, cols, type);
+}
+
+/**
+ * First row of a stripe when rows are split into equal stripes
+ * @param rows Number of rows
+ * @param stripes Number of stripes
+ * @param i Stripe index, stripes for the end of the last stripe
+ * @return Row index
+ */
+int stripeStart(int rows, int stripes, int i) {
+    return static_cast<int>(static_cast<int64_t>(rows) * i / stripes);
+}
+
+/**
+ * Make sure a workspace has scratch for every stripe
+ * @param workspace Workspace
+ * @param stripes Number of stripes
+ */
+void reserveStripes(EdgeWorkspace& workspace, int stripes) {
+    if (workspace.stripes.size() < static_cast<size_t>(stripes)) workspace.stripes.resize(stripes);
+}
+
+/**
+ * Apply Gaussian blur into the workspace
+ * Each stripe blurs its rows plus a halo of one kernel radius above and
+ * below, treated as an isolated image. The halo absorbs the artificial
+ * border, so every stripe produces exactly the rows a whole-image blur
+ * would, and the isolated ROI keeps OpenCV on its bit-exact 8-bit path.
+ * A stripe always covers the same rows, so its 8-bit scratch keeps its
+ * size from one call to the next.
+ *
+ * @param source Input image
+ * @param sigma Standard deviation for Gaussian kernel
+ * @param stripes Number of row stripes run in parallel
+ * @param workspace Receives the blurred image in blurred
+ */
+void blurInto(const cv::Mat& source, double sigma, int stripes, EdgeWorkspace& workspace) {
+    int kernelSize = EdgeDetector::calculateGaussianKernelSize(sigma);
+    int radius = kernelSize / 2;
+    cv::Mat& floatImage = workspace.blurred;
+    createIntermediate(floatImage, source.rows, source.cols, CV_MAKETYPE(CV_32F, source.channels()));
+
+    stripes = std::max(1, std::min(stripes, source.rows));
+    reserveStripes(workspace, stripes);
+
+    parallelStripes(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            int y0 = stripeStart(source.rows, stripes, i), y1 = stripeStart(source.rows, stripes, i + 1);
+            if (y0 == y1) continue;
+            int top = std::max(0, y0 - radius);
+            int bottom = std::min(source.rows, y1 + radius);
+
+            cv::Mat& blurred = workspace.stripes[i].blurred8;
+            createIntermediate(blurred, bottom - top, source.cols, source.type());
+            cv::GaussianBlur(source.rowRange(top, bottom), blurred, cv::Size(kernelSize, kernelSize), sigma, sigma,
+                             cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+
+            cv::Mat stripe = floatImage.rowRange(y0, y1);
+            blurred.rowRange(y0 - top, y1 - top).convertTo(stripe, CV_32F);
+        }
+    }, stripes);
+}
+
 /**
  * Apply Gaussian blur to the source image
  * @param source Input image
  * @param sigma Standard deviation for Gaussian kernel
+ * @param stripes Number of row stripes run in parallel
  * @return Blurred image
  */
-cv::Mat EdgeDetector::applyGaussianBlur(const cv::Mat& source, double sigma) {
-    cv::Mat blurred;
-    int kernelSize = calculateGaussianKernelSize(sigma);
-    cv::GaussianBlur(source, blurred, cv::Size(kernelSize, kernelSize), sigma);
-
-    cv::Mat floatImage;
-    blurred.convertTo(floatImage, CV_32F);
-    return floatImage;
-}
-
-/**
-* Calculate gradient coefficients (g-matrix)
-* For grayscale:
-* - gxx = |∂I/∂x|²
-* - gyy = |∂I/∂y|²
-* - gxy = (∂I/∂x)(∂I/∂y)
-* @param gradientX
-* @param gradientY
-* @param gxx
-* @param gyy
-* @param gxy
-*/
-void computeCoefficientsGray(const cv::Mat& gradientX, const cv::Mat& gradientY,
-                            cv::Mat& gxx, cv::Mat& gyy, cv::Mat& gxy) {
-    gxx = cv::Mat::zeros(gradientX.size(), CV_32F);
-    gyy = cv::Mat::zeros(gradientX.size(), CV_32F);
-    gxy = cv::Mat::zeros(gradientX.size(), CV_32F);
-
-    for (int y = 0; y < gradientX.rows; y++) {
-        for (int x = 0; x < gradientX.cols; x++) {
-            float dRdx = gradientX.at<float>(y, x);
-            float dRdy = gradientY.at<float>(y, x);
-            gxx.at<float>(y, x) = dRdx * dRdx;
-            gyy.at<float>(y, x) = dRdy * dRdy;
-            gxy.at<float>(y, x) = dRdx * dRdy;
-        }
-    }
+cv::Mat EdgeDetector::applyGaussianBlur(const cv::Mat& source, double sigma, int stripes) {
+    EdgeWorkspace workspace;
+    createOutput(workspace.blurred, source.rows, source.cols, CV_MAKETYPE(CV_32F, source.channels()));
+    blurInto(source, sigma, stripes, workspace);
+    return workspace.blurred;
 }
 
 /**
- * Calculate gradient coefficients for color images
- * Combines RGB channels:
- * - gxx = Σ|∂C/∂x|² for C in {R,G,B}
- * - gyy = Σ|∂C/∂y|² for C in {R,G,B}
- * - gxy = Σ(∂C/∂x)(∂C/∂y) for C in {R,G,B}
- * @param gradientX
- * @param gradientY
+ * Mirror an index into [0, length) the way BORDER_REFLECT_101 does
+ * (-1 -> 1, length -> length - 2), matching the default border of cv::Sobel.
+ * @param p Index, at most one step outside the range
+ * @param length Range length
+ * @return Index inside the range
+ */
+inline int reflectIndex(int p, int length) {
+    if (length == 1) return 0;
+    if (p < 0) return 1;
+    if (p >= length) return length - 2;
+    return p;
+}
+
+// Minimax fit of atan(a)/a as a polynomial in a² on [0, 1].
+// Max absolute error of a * P(a²) against std::atan is 1.7e-6 rad.
+static constexpr float ATAN_P0 = 0.99997726f;
+static constexpr float ATAN_P1 = -0.33262347f;
+static constexpr float ATAN_P2 = 0.19354346f;
+static constexpr float ATAN_P3 = -0.11643287f;
+static constexpr float ATAN_P4 = 0.05265332f;
+static constexpr float ATAN_P5 = -0.01172120f;
+
+/**
+ * Polynomial atan2
+ * Reduces to atan(min/max) on [0, 1] and unfolds the octant. Matches
+ * std::atan2 including the sign of zero y and atan2(0, 0) = 0, with an
+ * absolute error below 2e-6 rad.
+ *
+ * @param y
+ * @param x
+ * @return Angle in (-π, π]
+ */
+inline float polyAtan2(float y, float x) {
+    float ax = std::abs(x), ay = std::abs(y);
+    float a = std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN);
+    float z = a * a;
+    float r = ((((ATAN_P5 * z + ATAN_P4) * z + ATAN_P3) * z + ATAN_P2) * z + ATAN_P1) * z + ATAN_P0;
+    r *= a;
+    if (ay > ax) r = static_cast<float>(CV_PI / 2) - r;
+    if (x < 0) r = static_cast<float>(CV_PI) - r;
+    return std::copysign(r, y);
+}
+
+/**
+ * Gradient magnitude from the g-matrix
+ * With θ = (1/2)tan⁻¹[2gxy/(gxx - gyy)], the terms (gxx - gyy)cos2θ + 2gxy sin2θ
+ * of F₀ collapse to √[(gxx - gyy)² + 4gxy²], the eigenvalue form:
+ * F₀(x,y) = √[1/2((gxx + gyy) + √((gxx - gyy)² + 4gxy²))]
+ * so the magnitude needs no trigonometry. Against the previous
+ * atan2/cos/sin evaluation it agrees to float rounding.
+ *
  * @param gxx
  * @param gyy
  * @param gxy
+ * @return Magnitude
  */
-void computeCoefficientsColor(const std::vector<cv::Mat>& gradientX,
-                            const std::vector<cv::Mat>& gradientY,
-                            cv::Mat& gxx, cv::Mat& gyy, cv::Mat& gxy) {
-    gxx = cv::Mat::zeros(gradientX[0].size(), CV_32F);
-    gyy = cv::Mat::zeros(gradientX[0].size(), CV_32F);
-    gxy = cv::Mat::zeros(gradientX[0].size(), CV_32F);
-
-    for (int y = 0; y < gradientX[0].rows; y++) {
-        for (int x = 0; x < gradientX[0].cols; x++) {
-            for (int i = 0; i < 3; i++) {
-                gxx.at<float>(y, x) += std::pow(gradientX[i].at<float>(y, x), 2);
-                gyy.at<float>(y, x) += std::pow(gradientY[i].at<float>(y, x), 2);
-                gxy.at<float>(y, x) += gradientX[i].at<float>(y, x) * gradientY[i].at<float>(y, x);
-            }
-        }
-    }
+inline float tensorMagnitude(float gxx, float gyy, float gxy) {
+    float d = gxx - gyy;
+    float t = 2 * gxy;
+    return std::sqrt(0.5f * ((gxx + gyy) + std::sqrt(d * d + t * t)));
 }
 
 /**
- * Calculate gradient magnitude using formula:
- * F₀(x,y) = √[1/2((gxx + gyy) + (gxx - gyy)cos2θ + 2gxy sin2θ)]
+ * Gradient direction from the g-matrix
+ * θ(x,y) = (1/2)tan⁻¹[2gxy/(gxx - gyy)], within 1e-6 rad of std::atan2.
  *
  * @param gxx
  * @param gyy
  * @param gxy
- * @param magnitude
- */
-void calculateGradientMagnitude(const cv::Mat& gxx, const cv::Mat& gyy,
-                              const cv::Mat& gxy, cv::Mat& magnitude) {
-    magnitude = cv::Mat::zeros(gxx.size(), CV_32F);
-
-    for (int y = 0; y < gxx.rows; y++) {
-        for (int x = 0; x < gxx.cols; x++) {
-            float numerator = 2 * gxy.at<float>(y, x);
-            float denominator = gxx.at<float>(y, x) - gyy.at<float>(y, x);
-            float theta = 0.5 * std::atan2(numerator, denominator);
-
-            float cos2theta = std::cos(2 * theta);
-            float sin2theta = std::sin(2 * theta);
-
-            magnitude.at<float>(y, x) = std::sqrt(0.5 * (
-                (gxx.at<float>(y, x) + gyy.at<float>(y, x)) +
-                (gxx.at<float>(y, x) - gyy.at<float>(y, x)) * cos2theta +
-                2 * gxy.at<float>(y, x) * sin2theta
-            ));
-        }
-    }
+ * @return Direction in radians, in (-π/2, π/2]
+ */
+inline float tensorDirection(float gxx, float gyy, float gxy) {
+    return 0.5f * polyAtan2(2 * gxy, gxx - gyy);
 }
 
 /**
- * Calculate gradient direction using formula:
- * θ(x,y) = (1/2)tan⁻¹[2gxy/(gxx - gyy)]
+ * Non-maximum suppression sector from the g-matrix
+ * NMS compares against one of four neighbour pairs, picked by θ in
+ * [0°, 180°) with boundaries at 22.5° + k·45°. The tensor gives
+ * 2θ = atan2(2gxy, gxx - gyy) directly, and in 2θ those boundaries are the
+ * diagonals |2gxy| = |gxx - gyy|, so the sector follows from two
+ * comparisons without any trigonometry:
+ * - 0: horizontal neighbours  (θ near 0°)
+ * - 1: anti-diagonal          (θ near 45°)
+ * - 2: vertical neighbours    (θ near 90°)
+ * - 3: main diagonal          (θ near 135°)
+ * It matches quantising the angle except for float rounding exactly on a
+ * boundary.
  *
  * @param gxx
  * @param gyy
  * @param gxy
- * @param direction
+ * @return Sector code 0-3
  */
-void calculateGradientDirection(const cv::Mat& gxx, const cv::Mat& gyy,
-                              const cv::Mat& gxy, cv::Mat& direction) {
-    direction = cv::Mat::zeros(gxx.size(), CV_32F);
+inline uchar tensorSector(float gxx, float gyy, float gxy) {
+    float d = gxx - gyy;
+    float t = 2 * gxy;
+    if (t >= d && t > -d) return 1;
+    if (t > d && t <= -d) return 2;
+    return t >= -d ? 0 : 3;
+}
+
+/**
+ * Non-maximum suppression sector from a direction in radians
+ * @param angle Direction in radians
+ * @return Sector code 0-3 (see tensorSector)
+ */
+inline uchar angleSector(float angle) {
+    float angleDeg = angle * 180.0 / CV_PI;
+    if (angleDeg < 0) angleDeg += 180.0;
+
+    if (22.5 <= angleDeg && angleDeg < 67.5) return 1;
+    if (67.5 <= angleDeg && angleDeg < 112.5) return 2;
+    if (112.5 <= angleDeg && angleDeg < 157.5) return 3;
+    return 0;
+}
+
+/**
+ * Fused Sobel and structure tensor for one pixel
+ * Computes the 3x3 Sobel derivatives of every channel (with the Y axis
+ * pointing up) and accumulates the g-matrix in registers:
+ * - gxx = Σ|∂C/∂x|²
+ * - gyy = Σ|∂C/∂y|²
+ * - gxy = Σ(∂C/∂x)(∂C/∂y)
+ *
+ * @tparam CN Number of interleaved channels (1 or 3)
+ * @tparam SECTOR Write a sector code instead of a direction
+ * @param up Row above (already reflected at the image border)
+ * @param mid Current row
+ * @param down Row below (already reflected at the image border)
+ * @param cols Row width in pixels
+ * @param x Column
+ * @param magnitude Output magnitude row
+ * @param direction Output direction row (unused with SECTOR)
+ * @param sector Output sector row (SECTOR only)
+ */
+template<int CN, bool SECTOR>
+inline void gradientPixel(const float* up, const float* mid, const float* down, int cols, int x,
+                          float* magnitude, float* direction, uchar* sector) {
+    const int l = reflectIndex(x - 1, cols) * CN;
+    const int c = x * CN;
+    const int r = reflectIndex(x + 1, cols) * CN;
 
-    for (int y = 0; y < gxx.rows; y++) {
-        for (int x = 0; x < gxx.cols; x++) {
-            float numerator = 2 * gxy.at<float>(y, x);
-            float denominator = gxx.at<float>(y, x) - gyy.at<float>(y, x);
-            direction.at<float>(y, x) = 0.5 * atan2(numerator, denominator);
+    float gxx = 0, gyy = 0, gxy = 0;
+    for (int i = 0; i < CN; i++) {
+        float dx = (mid[r + i] - mid[l + i]) * 2 + ((up[r + i] - up[l + i]) + (down[r + i] - down[l + i]));
+        float dy = (up[l + i] + up[c + i] * 2 + up[r + i]) - (down[l + i] + down[c + i] * 2 + down[r + i]);
+        gxx += dx * dx;
+        gyy += dy * dy;
+        gxy += dx * dy;
+    }
+
+    magnitude[x] = tensorMagnitude(gxx, gyy, gxy);
+    if constexpr (SECTOR) {
+        sector[x] = tensorSector(gxx, gyy, gxy);
+    } else {
+        direction[x] = tensorDirection(gxx, gyy, gxy);
+    }
+}
+
+#if CV_SIMD
+/**
+ * Load one vector of pixels, split into channels
+ * @tparam CN Number of interleaved channels (1 or 3)
+ * @param p First pixel
+ * @param channels Output, one register per channel
+ */
+template<int CN>
+inline void loadChannels(const float* p, cv::v_float32 (&channels)[CN]) {
+    if constexpr (CN == 1) {
+        channels[0] = cv::v_load(p);
+    } else {
+        cv::v_load_deinterleave(p, channels[0], channels[1], channels[2]);
+    }
+}
+
+/**
+ * Vectorised polynomial atan2, lane for lane identical in method to polyAtan2
+ * @param y
+ * @param x
+ * @return Angle in (-π, π]
+ */
+inline cv::v_float32 polyAtan2(const cv::v_float32& y, const cv::v_float32& x) {
+    const cv::v_float32 signMask = cv::v_reinterpret_as_f32(cv::v_setall_u32(0x80000000u));
+    cv::v_float32 ax = cv::v_abs(x), ay = cv::v_abs(y);
+    cv::v_float32 a = cv::v_div(cv::v_min(ax, ay), cv::v_max(cv::v_max(ax, ay), cv::v_setall_f32(FLT_MIN)));
+    cv::v_float32 z = cv::v_mul(a, a);
+
+    cv::v_float32 r = cv::v_add(cv::v_mul(cv::v_setall_f32(ATAN_P5), z), cv::v_setall_f32(ATAN_P4));
+    r = cv::v_add(cv::v_mul(r, z), cv::v_setall_f32(ATAN_P3));
+    r = cv::v_add(cv::v_mul(r, z), cv::v_setall_f32(ATAN_P2));
+    r = cv::v_add(cv::v_mul(r, z), cv::v_setall_f32(ATAN_P1));
+    r = cv::v_add(cv::v_mul(r, z), cv::v_setall_f32(ATAN_P0));
+    r = cv::v_mul(r, a);
+
+    r = cv::v_select(cv::v_gt(ay, ax), cv::v_sub(cv::v_setall_f32(static_cast<float>(CV_PI / 2)), r), r);
+    r = cv::v_select(cv::v_lt(x, cv::v_setzero_f32()), cv::v_sub(cv::v_setall_f32(static_cast<float>(CV_PI)), r), r);
+    return cv::v_or(r, cv::v_and(y, signMask));
+}
+
+/**
+ * Vectorised tensorSector, with the comparisons turned into lane masks
+ * @param d gxx - gyy
+ * @param t 2gxy
+ * @return Sector code 0-3 per lane
+ */
+inline cv::v_int32 tensorSector(const cv::v_float32& d, const cv::v_float32& t) {
+    cv::v_float32 negD = cv::v_sub(cv::v_setzero_f32(), d);
+    cv::v_int32 onAnti = cv::v_reinterpret_as_s32(cv::v_ge(t, negD));
+    cv::v_int32 aboveAnti = cv::v_reinterpret_as_s32(cv::v_gt(t, negD));
+    cv::v_int32 onMain = cv::v_reinterpret_as_s32(cv::v_ge(t, d));
+    cv::v_int32 aboveMain = cv::v_reinterpret_as_s32(cv::v_gt(t, d));
+
+    cv::v_int32 code = cv::v_select(onAnti, cv::v_setall_s32(0), cv::v_setall_s32(3));
+    code = cv::v_select(cv::v_and(aboveMain, cv::v_not(aboveAnti)), cv::v_setall_s32(2), code);
+    return cv::v_select(cv::v_and(onMain, aboveAnti), cv::v_setall_s32(1), code);
+}
+#endif
+
+/**
+ * Fused Sobel, structure tensor and magnitude/direction for one row
+ * Interior pixels are processed a vector at a time with universal
+ * intrinsics: derivatives, g-matrix and the closed-form magnitude all stay
+ * in registers. The two border pixels and the tail use the scalar path.
+ *
+ * @tparam CN Number of interleaved channels (1 or 3)
+ * @tparam SECTOR Write a sector code instead of a direction
+ * @param up Row above (already reflected at the image border)
+ * @param mid Current row
+ * @param down Row below (already reflected at the image border)
+ * @param cols Row width in pixels
+ * @param magnitude Output magnitude row
+ * @param direction Output direction row (unused with SECTOR)
+ * @param sector Output sector row (SECTOR only)
+ */
+template<int CN, bool SECTOR>
+void gradientRow(const float* up, const float* mid, const float* down, int cols,
+                 float* magnitude, float* direction, uchar* sector) {
+    int x = 0;
+#if CV_SIMD
+    if (cols > 2) {
+        gradientPixel<CN, SECTOR>(up, mid, down, cols, 0, magnitude, direction, sector);
+        x = 1;
+
+        const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+        const cv::v_float32 two = cv::v_setall_f32(2.f), half = cv::v_setall_f32(0.5f);
+
+        for (; x + lanes <= cols - 1; x += lanes) {
+            cv::v_float32 ul[CN], uc[CN], ur[CN], ml[CN], mr[CN], dl[CN], dc[CN], dr[CN];
+            loadChannels<CN>(up + (x - 1) * CN, ul);
+            loadChannels<CN>(up + x * CN, uc);
+            loadChannels<CN>(up + (x + 1) * CN, ur);
+            loadChannels<CN>(mid + (x - 1) * CN, ml);
+            loadChannels<CN>(mid + (x + 1) * CN, mr);
+            loadChannels<CN>(down + (x - 1) * CN, dl);
+            loadChannels<CN>(down + x * CN, dc);
+            loadChannels<CN>(down + (x + 1) * CN, dr);
+
+            cv::v_float32 gxx = cv::v_setzero_f32(), gyy = cv::v_setzero_f32(), gxy = cv::v_setzero_f32();
+            for (int i = 0; i < CN; i++) {
+                cv::v_float32 dx = cv::v_add(cv::v_mul(cv::v_sub(mr[i], ml[i]), two),
+                                             cv::v_add(cv::v_sub(ur[i], ul[i]), cv::v_sub(dr[i], dl[i])));
+                cv::v_float32 dy = cv::v_sub(cv::v_add(cv::v_add(ul[i], cv::v_mul(uc[i], two)), ur[i]),
+                                             cv::v_add(cv::v_add(dl[i], cv::v_mul(dc[i], two)), dr[i]));
+                gxx = cv::v_add(gxx, cv::v_mul(dx, dx));
+                gyy = cv::v_add(gyy, cv::v_mul(dy, dy));
+                gxy = cv::v_add(gxy, cv::v_mul(dx, dy));
+            }
+
+            cv::v_float32 d = cv::v_sub(gxx, gyy);
+            cv::v_float32 t = cv::v_mul(gxy, two);
+            cv::v_float32 root = cv::v_sqrt(cv::v_add(cv::v_mul(d, d), cv::v_mul(t, t)));
+            cv::v_store(magnitude + x, cv::v_sqrt(cv::v_mul(half, cv::v_add(cv::v_add(gxx, gyy), root))));
+
+            if constexpr (SECTOR) {
+                int codes[cv::VTraits<cv::v_int32>::max_nlanes];
+                cv::v_store(codes, tensorSector(d, t));
+                for (int i = 0; i < lanes; i++) sector[x + i] = static_cast<uchar>(codes[i]);
+            } else {
+                cv::v_store(direction + x, cv::v_mul(half, polyAtan2(t, d)));
+            }
         }
     }
+#endif
+    for (; x < cols; x++) {
+        gradientPixel<CN, SECTOR>(up, mid, down, cols, x, magnitude, direction, sector);
+    }
+}
+
+/**
+ * Largest value in a row segment
+ * @param row First value
+ * @param count Number of values
+ * @return Maximum, or 0 for an empty segment
+ */
+float rowMax(const float* row, int count) {
+    float result = 0;
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    if (count >= lanes) {
+        cv::v_float32 acc = cv::v_setzero_f32();
+        for (; x + lanes <= count; x += lanes) acc = cv::v_max(acc, cv::v_load(row + x));
+        result = cv::v_reduce_max(acc);
+    }
+#endif
+    for (; x < count; x++) result = std::max(result, row[x]);
+    return result;
+}
+
+/**
+ * Compute magnitude and direction with a single row-streaming pass
+ * Each output row reads three input rows, so no derivative or tensor
+ * planes are materialised. The largest magnitude away from the image
+ * border, the only pixels non-maximum suppression can keep, is tracked
+ * on the way.
+ *
+ * @tparam CN Number of interleaved channels (1 or 3)
+ * @tparam SECTOR Emit a CV_8U sector map instead of a CV_32F direction
+ * @param image Blurred CV_32F image
+ * @param stripes Number of row stripes run in parallel
+ * @param result Output magnitude and direction or sector; the other one is released
+ */
+template<int CN, bool SECTOR>
+void computeFusedGradients(const cv::Mat& image, int stripes, GradientResult& result) {
+    createIntermediate(result.magnitude, image.rows, image.cols, CV_32F);
+    if (SECTOR) {
+        createIntermediate(result.sector, image.rows, image.cols, CV_8U);
+        result.direction.release();
+    } else {
+        createIntermediate(result.direction, image.rows, image.cols, CV_32F);
+        result.sector.release();
+    }
+
+    std::atomic<float> maxMagnitude(0.f);
+
+    parallelStripes(cv::Range(0, image.rows), [&](const cv::Range& range) {
+        float stripeMax = 0;
+        for (int y = range.start; y < range.end; y++) {
+            gradientRow<CN, SECTOR>(image.ptr<float>(reflectIndex(y - 1, image.rows)),
+                                    image.ptr<float>(y),
+                                    image.ptr<float>(reflectIndex(y + 1, image.rows)),
+                                    image.cols,
+                                    result.magnitude.ptr<float>(y),
+                                    SECTOR ? nullptr : result.direction.ptr<float>(y),
+                                    SECTOR ? result.sector.ptr<uchar>(y) : nullptr);
+
+            if (y > 0 && y < image.rows - 1) {
+                stripeMax = std::max(stripeMax, rowMax(result.magnitude.ptr<float>(y) + 1, image.cols - 2));
+            }
+        }
+        atomicMax(maxMagnitude, stripeMax);
+    }, stripes);
+
+    result.maxMagnitude = maxMagnitude.load();
 }
 
 /**
  * Compute gradients for grayscale images
  * @param image Input image
- * @return GradientResult containing magnitude and direction
+ * @param encoding How the direction is returned
+ * @param stripes Number of row stripes
+ * @param result Output magnitude and direction or sector
  */
-GradientResult EdgeDetector::computeGrayGradients(const cv::Mat& image) {
-    cv::Mat gradientX, gradientY;
-    cv::Sobel(image, gradientX, CV_32F, 1, 0, 3);
-    cv::Sobel(image, gradientY, CV_32F, 0, 1, 3);
-    gradientY = -gradientY;
+void EdgeDetector::computeGrayGradients(const cv::Mat& image, DirectionEncoding encoding, int stripes,
+                                        GradientResult& result) {
+    if (encoding == DirectionEncoding::Sector) computeFusedGradients<1, true>(image, stripes, result);
+    else computeFusedGradients<1, false>(image, stripes, result);
+}
 
-    cv::Mat gxx, gyy, gxy;
-    computeCoefficientsGray(gradientX, gradientY, gxx, gyy, gxy);
+/**
+ * Compute gradients for color images
+ * Combines RGB channels in the g-matrix
+ * @param image Input image
+ * @param encoding How the direction is returned
+ * @param stripes Number of row stripes
+ * @param result Output magnitude and direction or sector
+ */
+void EdgeDetector::computeColorGradients(const cv::Mat& image, DirectionEncoding encoding, int stripes,
+                                         GradientResult& result) {
+    if (encoding == DirectionEncoding::Sector) computeFusedGradients<3, true>(image, stripes, result);
+    else computeFusedGradients<3, false>(image, stripes, result);
+}
 
+/**
+ * Compute gradients based on image type (color or grayscale)
+ * @param image Input image
+ * @param isColor Flag indicating if the image is color
+ * @param encoding How the direction is returned
+ * @param stripes Number of row stripes
+ * @param result Output magnitude and direction or sector
+ */
+void EdgeDetector::computeGradients(const cv::Mat& image, bool isColor, DirectionEncoding encoding, int stripes,
+                                    GradientResult& result) {
+    if (isColor) computeColorGradients(image, encoding, stripes, result);
+    else computeGrayGradients(image, encoding, stripes, result);
+}
+
+/**
+ * Compute gradients based on image type (color or grayscale)
+ * @param image Input image
+ * @param isColor Flag indicating if the image is color
+ * @param encoding How the direction is returned
+ * @param stripes Number of row stripes
+ * @return GradientResult containing magnitude and direction or sector
+ */
+GradientResult EdgeDetector::computeGradients(const cv::Mat& image, bool isColor, DirectionEncoding encoding,
+                                              int stripes) {
     GradientResult result;
-    calculateGradientMagnitude(gxx, gyy, gxy, result.magnitude);
-    calculateGradientDirection(gxx, gyy, gxy, result.direction);
+    createOutput(result.magnitude, image.rows, image.cols, CV_32F);
+    if (encoding == DirectionEncoding::Sector) createOutput(result.sector, image.rows, image.cols, CV_8U);
+    else createOutput(result.direction, image.rows, image.cols, CV_32F);
+    computeGradients(image, isColor, encoding, stripes, result);
     return result;
 }
 
 /**
- * Compute gradients for color images
- * @param image Input image
- * @return GradientResult containing magnitude and direction
+ * Non-maximum suppression for one row
+ * Keeps a pixel only if it is not smaller than its q and r neighbours
+ * along the gradient sector. Interior pixels are processed a vector at a
+ * time: the neighbours of all four sectors are loaded and the right pair is
+ * picked per lane with sector masks and blends, so there are no branches.
+ * The first and last pixel of the row are always zero.
+ *
+ * @param up Magnitude row above
+ * @param mid Magnitude row
+ * @param down Magnitude row below
+ * @param sector Sector codes of the row
+ * @param cols Row width in pixels
+ * @param dst Output suppressed row
  */
-GradientResult EdgeDetector::computeColorGradients(const cv::Mat& image) {
-    std::vector<cv::Mat> channels;
-    cv::split(image, channels);
+void suppressRow(const float* up, const float* mid, const float* down, const uchar* sector,
+                 int cols, float* dst) {
+    // Row and column offsets of the q and r neighbours for each sector
+    static constexpr int qy[] = {0, 1, 1, -1};
+    static constexpr int qx[] = {1, -1, 0, -1};
+    static constexpr int ry[] = {0, -1, -1, 1};
+    static constexpr int rx[] = {-1, 1, 0, 1};
 
-    std::vector<cv::Mat> gradientX(3), gradientY(3);
-    for (int i = 0; i < 3; i++) {
-        cv::Sobel(channels[i], gradientX[i], CV_32F, 1, 0, 3);
-        cv::Sobel(channels[i], gradientY[i], CV_32F, 0, 1, 3);
-        gradientY[i] = -gradientY[i];
-    }
+    dst[0] = 0;
+    if (cols < 2) return;
+    dst[cols - 1] = 0;
 
-    cv::Mat gxx, gyy, gxy;
-    computeCoefficientsColor(gradientX, gradientY, gxx, gyy, gxy);
+    int x = 1;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    const cv::v_uint32 s1 = cv::v_setall_u32(1), s2 = cv::v_setall_u32(2), s0 = cv::v_setall_u32(0);
 
-    GradientResult result;
-    calculateGradientMagnitude(gxx, gyy, gxy, result.magnitude);
-    calculateGradientDirection(gxx, gyy, gxy, result.direction);
-    return result;
+    for (; x + lanes <= cols - 1; x += lanes) {
+        cv::v_float32 m = cv::v_load(mid + x);
+        cv::v_float32 ml = cv::v_load(mid + x - 1), mr = cv::v_load(mid + x + 1);
+        cv::v_float32 ul = cv::v_load(up + x - 1), uc = cv::v_load(up + x), ur = cv::v_load(up + x + 1);
+        cv::v_float32 dl = cv::v_load(down + x - 1), dc = cv::v_load(down + x), dr = cv::v_load(down + x + 1);
+
+        cv::v_uint32 code = cv::v_load_expand_q(sector + x);
+        cv::v_float32 is0 = cv::v_reinterpret_as_f32(cv::v_eq(code, s0));
+        cv::v_float32 is1 = cv::v_reinterpret_as_f32(cv::v_eq(code, s1));
+        cv::v_float32 is2 = cv::v_reinterpret_as_f32(cv::v_eq(code, s2));
+
+        cv::v_float32 q = cv::v_select(is0, mr, cv::v_select(is1, dl, cv::v_select(is2, dc, ul)));
+        cv::v_float32 r = cv::v_select(is0, ml, cv::v_select(is1, ur, cv::v_select(is2, uc, dr)));
+        cv::v_float32 keep = cv::v_and(cv::v_ge(m, q), cv::v_ge(m, r));
+        cv::v_store(dst + x, cv::v_and(m, keep));
+    }
+#endif
+    const float* rows[] = {up, mid, down};
+    for (; x < cols - 1; x++) {
+        const int s = sector[x];
+        float m = mid[x];
+        float q = rows[1 + qy[s]][x + qx[s]];
+        float r = rows[1 + ry[s]][x + rx[s]];
+        dst[x] = m >= q && m >= r ? m : 0;
+    }
 }
 
 /**
- * Compute gradients based on image type (color or grayscale)
- * @param image Input image
- * @param isColor Flag indicating if the image is color
- * @return GradientResult containing magnitude and direction
+ * Sector codes for non-maximum suppression
+ * @param gradients GradientResult containing direction or sector
+ * @param stripes Number of row stripes
+ * @param sector Scratch for codes quantised from a radian direction
+ * @return The sector map of gradients, or sector filled from its direction
  */
-GradientResult EdgeDetector::computeGradients(const cv::Mat& image, bool isColor) {
-    return isColor ? computeColorGradients(image) : computeGrayGradients(image);
+const cv::Mat& sectorMap(const GradientResult& gradients, int stripes, cv::Mat& sector) {
+    if (!gradients.sector.empty()) return gradients.sector;
+
+    createIntermediate(sector, gradients.direction.rows, gradients.direction.cols, CV_8U);
+    parallelStripes(cv::Range(0, sector.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* angle = gradients.direction.ptr<float>(y);
+            uchar* code = sector.ptr<uchar>(y);
+            for (int x = 0; x < sector.cols; x++) code[x] = angleSector(angle[x]);
+        }
+    }, stripes);
+    return sector;
 }
 
 /**
  * Apply non-maximum suppression to the gradient magnitude
  * Thin edges by suppressing non-maximum pixels along gradient direction
- * Uses 8 possible directions (0°, 45°, 90°, 135°)
- * @param gradients GradientResult containing magnitude and direction
+ * Uses 8 possible directions (0°, 45°, 90°, 135°), looked up by sector
+ * code; a radian direction is quantised to sectors first.
+ * @param gradients GradientResult containing magnitude and direction or sector
+ * @param stripes Number of row stripes run in parallel
+ * @param sectorScratch Scratch for the sector map of a radian direction
+ * @param suppressed Output suppressed gradient magnitude
+ */
+void suppressInto(const GradientResult& gradients, int stripes, cv::Mat& sectorScratch, cv::Mat& suppressed) {
+    const cv::Mat& sector = sectorMap(gradients, stripes, sectorScratch);
+    const cv::Mat& magnitude = gradients.magnitude;
+    createOutput(suppressed, magnitude.rows, magnitude.cols, CV_32F);
+
+    parallelStripes(cv::Range(0, magnitude.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            float* dst = suppressed.ptr<float>(y);
+            if (y == 0 || y == magnitude.rows - 1) {
+                std::fill(dst, dst + magnitude.cols, 0.f);
+                continue;
+            }
+            suppressRow(magnitude.ptr<float>(y - 1), magnitude.ptr<float>(y), magnitude.ptr<float>(y + 1),
+                        sector.ptr<uchar>(y), magnitude.cols, dst);
+        }
+    }, stripes);
+}
+
+/**
+ * Apply non-maximum suppression to the gradient magnitude
+ * @param gradients GradientResult containing magnitude and direction or sector
+ * @param stripes Number of row stripes run in parallel
  * @return Suppressed gradient magnitude
  */
-cv::Mat EdgeDetector::applySuppression(const GradientResult& gradients) {
-    cv::Mat suppressed = cv::Mat::zeros(gradients.magnitude.size(), CV_32F);
+cv::Mat EdgeDetector::applySuppression(const GradientResult& gradients, int stripes) {
+    cv::Mat sector, suppressed;
+    suppressInto(gradients, stripes, sector, suppressed);
+    return suppressed;
+}
 
-    for (int y = 1; y < gradients.magnitude.rows - 1; y++) {
-        for (int x = 1; x < gradients.magnitude.cols - 1; x++) {
-            float angle = gradients.direction.at<float>(y, x);
-            float angleDeg = angle * 180.0 / CV_PI;
-            if (angleDeg < 0) angleDeg += 180.0;
+/**
+ * Gradient magnitude and sector code for one row, for callers that keep
+ * their own row buffers instead of full-size Mats
+ * @param up Blurred row above, reflected at the image border
+ * @param mid Blurred row
+ * @param down Blurred row below, reflected at the image border
+ * @param cols Row width in pixels
+ * @param isColor Flag indicating if the rows have three interleaved channels
+ * @param magnitude Output magnitude row
+ * @param sector Output sector row
+ */
+void EdgeDetector::computeGradientRow(const float* up, const float* mid, const float* down, int cols,
+                                      bool isColor, float* magnitude, uchar* sector) {
+    if (isColor) gradientRow<3, true>(up, mid, down, cols, magnitude, nullptr, sector);
+    else gradientRow<1, true>(up, mid, down, cols, magnitude, nullptr, sector);
+}
 
-            float q = 255.0, r = 255.0;
+/**
+ * Non-maximum suppression for one interior row
+ * @param up Magnitude row above
+ * @param mid Magnitude row
+ * @param down Magnitude row below
+ * @param sector Sector codes of the row
+ * @param cols Row width in pixels
+ * @param suppressed Output suppressed row
+ */
+void EdgeDetector::suppressGradientRow(const float* up, const float* mid, const float* down,
+                                       const uchar* sector, int cols, float* suppressed) {
+    suppressRow(up, mid, down, sector, cols, suppressed);
+}
+
+/**
+ * Classify one row of suppressed magnitudes
+ * Strong (>= highThr) anywhere, weak (>= lowThr) only away from the image
+ * border, since border pixels are never promoted by edge tracking.
+ *
+ * @param src Suppressed row
+ * @param cols Row width in pixels
+ * @param lowThr Absolute low threshold
+ * @param highThr Absolute high threshold
+ * @param interiorRow False for the first and last image row
+ * @param dst Output label row (0 / EDGE_WEAK / EDGE_STRONG)
+ * @param leftBorder Whether the first pixel is on the image border, false for a tile not at the left edge
+ * @param rightBorder Whether the last pixel is on the image border, false for a tile not at the right edge
+ */
+void EdgeDetector::classifyRow(const float* src, int cols, float lowThr, float highThr, bool interiorRow, uchar* dst,
+                               bool leftBorder, bool rightBorder) {
+    const int x0 = leftBorder ? 1 : 0;
+    const int x1 = rightBorder ? cols - 1 : cols;
+    for (int x = 0; x < cols; x++) {
+        float val = src[x];
+        bool interior = interiorRow && x >= x0 && x < x1;
+        if (val >= highThr) dst[x] = EdgeDetector::EDGE_STRONG;
+        else if (val >= lowThr && interior) dst[x] = EdgeDetector::EDGE_WEAK;
+        else dst[x] = 0;
+    }
+}
+
+/**
+ * Non-maximum suppression fused with double thresholding
+ * Thresholds are scaled by the maximum magnitude tracked by the gradient
+ * stage, so each suppressed row is classified straight into the label map
+ * while it is still in cache and no float suppressed image is stored.
+ *
+ * That maximum equals the maximum after suppression unless the largest
+ * interior magnitude loses to a border neighbour. The largest kept value
+ * is tracked as well, and in that rare case the rows are classified again
+ * against it, so the labels always match classifyEdges(applySuppression()).
+ * Absolute thresholds need no maximum and always take a single pass.
+ *
+ * @param gradients GradientResult containing magnitude, sector/direction and maximum
+ * @param lowThreshold Low threshold
+ * @param highThreshold High threshold
+ * @param mode Whether the thresholds are relative to the maximum or absolute
+ * @param stripes Number of row stripes run in parallel
+ * @param workspace Sector and per-stripe row scratch
+ * @param labels Output label map (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+void suppressAndClassifyInto(const GradientResult& gradients, float lowThreshold, float highThreshold,
+                             ThresholdMode mode, int stripes, EdgeWorkspace& workspace, cv::Mat& labels) {
+    const cv::Mat& sector = sectorMap(gradients, stripes, workspace.sector);
+    const cv::Mat& magnitude = gradients.magnitude;
+    const int rows = magnitude.rows, cols = magnitude.cols;
+
+    labels.create(magnitude.size(), CV_8U);
+    const bool relative = mode == ThresholdMode::Relative;
+    float maxVal = relative ? gradients.maxMagnitude : 1.f;
 
-            if ((0 <= angleDeg && angleDeg < 22.5) || (157.5 <= angleDeg && angleDeg <= 180)) {
-                q = gradients.magnitude.at<float>(y, x+1);
-                r = gradients.magnitude.at<float>(y, x-1);
+    stripes = std::max(1, std::min(stripes, rows));
+    reserveStripes(workspace, stripes);
+
+    for (int pass = 0; pass < 2; pass++) {
+        float highThr = highThreshold * maxVal;
+        float lowThr = lowThreshold * maxVal;
+        std::atomic<float> keptMax(0.f);
+
+        parallelStripes(cv::Range(0, stripes), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                std::vector<float>& row = workspace.stripes[i].row;
+                row.resize(cols);
+                float stripeMax = 0;
+
+                for (int y = stripeStart(rows, stripes, i); y < stripeStart(rows, stripes, i + 1); y++) {
+                    bool interiorRow = y > 0 && y < rows - 1;
+                    if (interiorRow) {
+                        suppressRow(magnitude.ptr<float>(y - 1), magnitude.ptr<float>(y),
+                                    magnitude.ptr<float>(y + 1), sector.ptr<uchar>(y), cols, row.data());
+                        stripeMax = std::max(stripeMax, rowMax(row.data(), cols));
+                    } else {
+                        std::fill(row.begin(), row.end(), 0.f);
+                    }
+                    EdgeDetector::classifyRow(row.data(), cols, lowThr, highThr, interiorRow, labels.ptr<uchar>(y));
+                }
+                atomicMax(keptMax, stripeMax);
             }
-            else if (22.5 <= angleDeg && angleDeg < 67.5) {
-                q = gradients.magnitude.at<float>(y+1, x-1);
-                r = gradients.magnitude.at<float>(y-1, x+1);
+        }, stripes);
+
+        if (!relative || keptMax.load() == maxVal) break;
+        maxVal = keptMax.load();
+    }
+}
+
+/**
+ * Non-maximum suppression fused with double thresholding
+ * @param gradients GradientResult containing magnitude, sector/direction and maximum
+ * @param lowThreshold Low threshold
+ * @param highThreshold High threshold
+ * @param mode Whether the thresholds are relative to the maximum or absolute
+ * @param stripes Number of row stripes run in parallel
+ * @return Label map (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+cv::Mat EdgeDetector::suppressAndClassify(const GradientResult& gradients, float lowThreshold,
+                                          float highThreshold, ThresholdMode mode, int stripes) {
+    EdgeWorkspace workspace;
+    cv::Mat labels;
+    suppressAndClassifyInto(gradients, lowThreshold, highThreshold, mode, stripes, workspace, labels);
+    return labels;
+}
+
+/**
+ * Rows per tile so that the intermediates of one tile fit in L2
+ * A row costs the 8-bit and float blurred rows plus a magnitude and a
+ * sector row; the blur and NMS halo rows come on top of the tile.
+ *
+ * @param cols Image width
+ * @param channels Number of channels
+ * @param radius Gaussian kernel radius
+ * @return Tile height in rows
+ */
+int EdgeDetector::calculateTileRows(int cols, int channels, int radius) {
+    size_t width = std::max(cols, 1);
+    size_t rowBytes = width * (channels * (1 + sizeof(float)) + sizeof(float) + 1);
+    size_t haloBytes = width * channels * (4 + 2 * radius) + 4 * rowBytes;
+    if (haloBytes >= L2_TILE_BYTES) return 8;
+    return std::max(8, static_cast<int>((L2_TILE_BYTES - haloBytes) / rowBytes));
+}
+
+/**
+ * Non-maximum suppression one tile of rows at a time
+ * Each tile blurs the source rows it needs (the tile, two gradient and NMS
+ * halo rows, and one kernel radius), computes gradients for the tile and
+ * one halo row, and suppresses the tile. Only the suppressed rows are
+ * written to a full-size Mat; the other intermediates stay in per-stripe
+ * scratch buffers of the workspace, sized for the tallest tile and reused
+ * for every tile. With absolute thresholds the suppressed rows are
+ * classified in the tile as well and only the label map is written.
+ *
+ * @param source Input image
+ * @param sigma Standard deviation for Gaussian kernel
+ * @param kernelSize Gaussian kernel size
+ * @param tileRows Rows per tile
+ * @param stripes Number of tile stripes run in parallel
+ * @param classify Write labels against lowThr/highThr instead of suppressed magnitudes
+ * @param lowThr Absolute low threshold
+ * @param highThr Absolute high threshold
+ * @param workspace Per-stripe tile scratch
+ * @param dst Output suppressed gradient magnitude, or label map when classifying
+ * @return Bytes of scratch used by one tile
+ */
+template<int CN, bool SECTOR>
+size_t suppressTiled(const cv::Mat& source, double sigma, int kernelSize, int tileRows, int stripes,
+                     bool classify, float lowThr, float highThr, EdgeWorkspace& workspace, cv::Mat& dst) {
+    const int rows = source.rows, cols = source.cols;
+    const int radius = kernelSize / 2;
+    const int tiles = (rows + tileRows - 1) / tileRows;
+    dst.create(source.size(), classify ? CV_8U : CV_32F);
+
+    stripes = std::max(1, std::min(stripes, tiles));
+    reserveStripes(workspace, stripes);
+
+    parallelStripes(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            EdgeWorkspace::Stripe& scratch = workspace.stripes[i];
+            createIntermediate(scratch.blurred8, std::min(rows, tileRows + 4 + 2 * radius), cols, source.type());
+            createIntermediate(scratch.blurred, std::min(rows, tileRows + 4), cols, CV_MAKETYPE(CV_32F, CN));
+            createIntermediate(scratch.magnitude, tileRows + 2, cols, CV_32F);
+            createIntermediate(scratch.sector, tileRows + 2, cols, CV_8U);
+            scratch.direction.resize(SECTOR ? 0 : cols);
+            scratch.row.resize(classify ? cols : 0);
+
+            for (int tile = stripeStart(tiles, stripes, i); tile < stripeStart(tiles, stripes, i + 1); tile++) {
+                int y0 = tile * tileRows, y1 = std::min(rows, y0 + tileRows);
+
+                // Blurred rows feeding the gradients of rows y0 - 1 .. y1
+                int b0 = std::max(0, y0 - 2), b1 = std::min(rows, y1 + 2);
+                int s0 = std::max(0, b0 - radius), s1 = std::min(rows, b1 + radius);
+                cv::Mat blurred8 = scratch.blurred8.rowRange(0, s1 - s0);
+                cv::GaussianBlur(source.rowRange(s0, s1), blurred8, cv::Size(kernelSize, kernelSize), sigma, sigma,
+                                 cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+                cv::Mat blurred = scratch.blurred.rowRange(0, b1 - b0);
+                blurred8.rowRange(b0 - s0, b1 - s0).convertTo(blurred, CV_32F);
+
+                int m0 = std::max(0, y0 - 1), m1 = std::min(rows, y1 + 1);
+                for (int y = m0; y < m1; y++) {
+                    uchar* code = scratch.sector.ptr<uchar>(y - m0);
+                    gradientRow<CN, SECTOR>(blurred.ptr<float>(reflectIndex(y - 1, rows) - b0),
+                                            blurred.ptr<float>(y - b0),
+                                            blurred.ptr<float>(reflectIndex(y + 1, rows) - b0),
+                                            cols,
+                                            scratch.magnitude.ptr<float>(y - m0),
+                                            SECTOR ? nullptr : scratch.direction.data(),
+                                            SECTOR ? code : nullptr);
+                    if (!SECTOR) {
+                        for (int x = 0; x < cols; x++) code[x] = angleSector(scratch.direction[x]);
+                    }
+                }
+
+                for (int y = y0; y < y1; y++) {
+                    float* suppressed = classify ? scratch.row.data() : dst.ptr<float>(y);
+                    bool interiorRow = y > 0 && y < rows - 1;
+                    if (interiorRow) {
+                        int r = y - m0;
+                        suppressRow(scratch.magnitude.ptr<float>(r - 1), scratch.magnitude.ptr<float>(r),
+                                    scratch.magnitude.ptr<float>(r + 1), scratch.sector.ptr<uchar>(r), cols,
+                                    suppressed);
+                    } else {
+                        std::fill(suppressed, suppressed + cols, 0.f);
+                    }
+                    if (classify) {
+                        EdgeDetector::classifyRow(suppressed, cols, lowThr, highThr, interiorRow, dst.ptr<uchar>(y));
+                    }
+                }
             }
-            else if (67.5 <= angleDeg && angleDeg < 112.5) {
-                q = gradients.magnitude.at<float>(y+1, x);
-                r = gradients.magnitude.at<float>(y-1, x);
+        }
+    }, stripes);
+
+    size_t haloRows = tileRows + 4 + 2 * radius;
+    return haloRows * cols * CN + (tileRows + 4) * cols * CN * sizeof(float)
+         + (tileRows + 2) * cols * (sizeof(float) + 1);
+}
+
+/**
+ * Run the pipeline up to non-maximum suppression tile by tile
+ * @param params GradientParams containing input image and parameters
+ * @param stripes Number of tile stripes
+ * @param classify Classify against the absolute thresholds of params inside each tile
+ * @param tileBytes Output bytes of scratch used by one tile
+ * @param workspace Per-stripe tile scratch
+ * @param dst Output suppressed gradient magnitude, or the label map when classifying
+ */
+void EdgeDetector::suppressTiles(const GradientParams& params, int stripes, bool classify, size_t& tileBytes,
+                                 EdgeWorkspace& workspace, cv::Mat& dst) {
+    const cv::Mat& source = params.source;
+    const double sigma = params.sigma;
+    const float low = params.lowThreshold, high = params.highThreshold;
+    int kernelSize = calculateGaussianKernelSize(sigma);
+    int tileRows = params.tileRows > 0 ? params.tileRows
+                                       : calculateTileRows(source.cols, source.channels(), kernelSize / 2);
+    bool sector = params.directionEncoding == DirectionEncoding::Sector;
+
+    if (params.isColor) {
+        tileBytes = sector ? suppressTiled<3, true>(source, sigma, kernelSize, tileRows, stripes,
+                                                    classify, low, high, workspace, dst)
+                           : suppressTiled<3, false>(source, sigma, kernelSize, tileRows, stripes,
+                                                     classify, low, high, workspace, dst);
+    } else {
+        tileBytes = sector ? suppressTiled<1, true>(source, sigma, kernelSize, tileRows, stripes,
+                                                    classify, low, high, workspace, dst)
+                           : suppressTiled<1, false>(source, sigma, kernelSize, tileRows, stripes,
+                                                     classify, low, high, workspace, dst);
+    }
+}
+
+/**
+ * Hysteresis edge tracking with a worklist
+ * Seeds a stack from every strong pixel and promotes the 8-connected weak
+ * neighbours, so each weak pixel is visited at most once. Weak pixels that
+ * are never reached are cleared afterwards.
+ *
+ * @param labels Label map (0 / EDGE_WEAK / EDGE_STRONG), updated in place
+ * @param workspace Holds the stack
+ */
+void EdgeDetector::trackEdgesWorklist(cv::Mat& labels, EdgeWorkspace& workspace) {
+    static constexpr int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    static constexpr int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+    std::vector<cv::Point>& stack = workspace.stack;
+    stack.clear();
+
+    for (int y = 0; y < labels.rows; y++) {
+        for (int x = 0; x < labels.cols; x++) {
+            if (labels.at<uchar>(y, x) != EDGE_STRONG) continue;
+
+            stack.emplace_back(x, y);
+            while (!stack.empty()) {
+                cv::Point p = stack.back();
+                stack.pop_back();
+
+                for (int i = 0; i < 8; i++) {
+                    int nx = p.x + dx[i];
+                    int ny = p.y + dy[i];
+                    if (nx < 0 || ny < 0 || nx >= labels.cols || ny >= labels.rows) continue;
+
+                    uchar& neighbour = labels.at<uchar>(ny, nx);
+                    if (neighbour == EDGE_WEAK) {
+                        neighbour = EDGE_STRONG;
+                        stack.emplace_back(nx, ny);
+                    }
+                }
             }
-            else if (112.5 <= angleDeg && angleDeg < 157.5) {
-                q = gradients.magnitude.at<float>(y-1, x-1);
-                r = gradients.magnitude.at<float>(y+1, x+1);
+        }
+    }
+
+    for (int y = 0; y < labels.rows; y++) {
+        uchar* row = labels.ptr<uchar>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            if (row[x] == EDGE_WEAK) row[x] = 0;
+        }
+    }
+}
+
+/**
+ * Find the root of a pixel in a shared union-find forest
+ * Path halving is done with a CAS, which is safe under concurrent unions
+ * because it only ever moves a pixel closer to its root.
+ *
+ * @param parent Parent array shared by all threads
+ * @param p Node index
+ * @return Root index
+ */
+int findRoot(std::atomic<int>* parent, int p) {
+    while (true) {
+        int q = parent[p].load(std::memory_order_relaxed);
+        if (q == p) return p;
+
+        int r = parent[q].load(std::memory_order_relaxed);
+        if (r != q) parent[p].compare_exchange_weak(q, r, std::memory_order_relaxed);
+        p = r;
+    }
+}
+
+/**
+ * Merge the components of two nodes without locks
+ * A root is only ever linked to a smaller root, so a failed CAS just means
+ * another thread got there first and the roots are looked up again.
+ *
+ * @param parent Parent array shared by all threads
+ * @param a First node
+ * @param b Second node
+ */
+void uniteRoots(std::atomic<int>* parent, int a, int b) {
+    while (true) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+
+        int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+/**
+ * Hysteresis edge tracking with parallel connected components
+ * 1. Each row stripe labels its weak/strong pixels with local unions
+ * 2. Labels are joined across stripe borders with lock-free unions
+ * 3. A component is kept when it contains a strong pixel
+ *
+ * Node 0 is a sentinel that every strong pixel is joined to. Since roots
+ * always link to the smaller index, a pixel is an edge exactly when its
+ * root is the sentinel, which makes the result independent of the stripe
+ * layout and thread count.
+ *
+ * @param labels Label map (0 / EDGE_WEAK / EDGE_STRONG), updated in place, below 2^31 - 1 pixels
+ * @param stripes Number of row stripes, 0 for one per OpenCV thread
+ * @param workspace Holds the parent array, grown when the image is larger
+ */
+void EdgeDetector::trackEdgesUnionFind(cv::Mat& labels, int stripes, EdgeWorkspace& workspace) {
+    const int rows = labels.rows;
+    const int cols = labels.cols;
+    stripes = std::max(1, std::min(rows, resolveStripes(stripes)));
+
+    // Node ids are ints, so the image may have at most INT_MAX - 1 pixels
+    size_t nodes = static_cast<size_t>(rows) * cols + 1;
+    CV_Assert(nodes <= static_cast<size_t>(INT_MAX));
+    if (workspace.parentSize < nodes) {
+        workspace.parent.reset(new std::atomic<int>[nodes]);
+        workspace.parentSize = nodes;
+    }
+    std::atomic<int>* parent = workspace.parent.get();
+    parent[0].store(0, std::memory_order_relaxed);
+    auto node = [cols](int y, int x) { return y * cols + x + 1; };
+    auto firstRow = [rows, stripes](int i) { return stripeStart(rows, stripes, i); };
+
+    parallelStripes(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            int y0 = firstRow(i), y1 = firstRow(i + 1);
+            for (int y = y0; y < y1; y++) {
+                const uchar* row = labels.ptr<uchar>(y);
+                const uchar* above = y > y0 ? labels.ptr<uchar>(y - 1) : nullptr;
+
+                for (int x = 0; x < cols; x++) {
+                    if (!row[x]) continue;
+
+                    int p = node(y, x);
+                    parent[p].store(p, std::memory_order_relaxed);
+                    if (row[x] == EDGE_STRONG) uniteRoots(parent, p, 0);
+                    if (x > 0 && row[x - 1]) uniteRoots(parent, p, p - 1);
+                    if (above) {
+                        for (int nx = std::max(0, x - 1); nx <= std::min(cols - 1, x + 1); nx++) {
+                            if (above[nx]) uniteRoots(parent, p, node(y - 1, nx));
+                        }
+                    }
+                }
             }
+        }
+    }, stripes);
+
+    parallelStripes(cv::Range(1, stripes), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            int y = firstRow(i);
+            const uchar* row = labels.ptr<uchar>(y);
+            const uchar* above = labels.ptr<uchar>(y - 1);
 
-            suppressed.at<float>(y, x) = gradients.magnitude.at<float>(y, x) >= q &&
-                                        gradients.magnitude.at<float>(y, x) >= r ?
-                                        gradients.magnitude.at<float>(y, x) : 0;
+            for (int x = 0; x < cols; x++) {
+                if (!row[x]) continue;
+                for (int nx = std::max(0, x - 1); nx <= std::min(cols - 1, x + 1); nx++) {
+                    if (above[nx]) uniteRoots(parent, node(y, x), node(y - 1, nx));
+                }
+            }
+        }
+    }, stripes);
+
+    parallelStripes(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int y = firstRow(range.start); y < firstRow(range.end); y++) {
+            uchar* row = labels.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++) {
+                if (row[x]) row[x] = findRoot(parent, node(y, x)) == 0 ? EDGE_STRONG : 0;
+            }
         }
+    }, stripes);
+}
+
+/**
+ * Grow seed bits along a packed row through passable bits
+ * Uses a Kogge-Stone occluded fill inside each word (six shift/AND/OR
+ * steps cover all 64 bits) and carries the end bit into the next word,
+ * first towards higher columns and then back towards lower ones.
+ *
+ * @param seed Seed bits, grown in place
+ * @param pass Passable (weak or strong) bits
+ * @param words Number of 64-bit words per row
+ */
+void fillPackedRow(uint64_t* seed, const uint64_t* pass, int words) {
+    uint64_t carry = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t p = pass[w];
+        uint64_t g = seed[w] | (carry & p);
+        g |= p & (g << 1);  p &= p << 1;
+        g |= p & (g << 2);  p &= p << 2;
+        g |= p & (g << 4);  p &= p << 4;
+        g |= p & (g << 8);  p &= p << 8;
+        g |= p & (g << 16); p &= p << 16;
+        g |= p & (g << 32);
+        seed[w] = g;
+        carry = g >> 63;
     }
-    return suppressed;
+
+    carry = 0;
+    for (int w = words - 1; w >= 0; w--) {
+        uint64_t p = pass[w];
+        uint64_t g = seed[w] | ((carry << 63) & p);
+        g |= p & (g >> 1);  p &= p >> 1;
+        g |= p & (g >> 2);  p &= p >> 2;
+        g |= p & (g >> 4);  p &= p >> 4;
+        g |= p & (g >> 8);  p &= p >> 8;
+        g |= p & (g >> 16); p &= p >> 16;
+        g |= p & (g >> 32);
+        seed[w] = g;
+        carry = g & 1;
+    }
+}
+
+/**
+ * Pull edges into a row from an adjacent row
+ * The adjacent row is dilated by one column on each side, masked with the
+ * passable bits and the new bits are filled along the row.
+ *
+ * @param edges Edge bits of the row being updated
+ * @param pass Passable bits of the row being updated
+ * @param neighbour Edge bits of the adjacent row
+ * @param words Number of 64-bit words per row
+ * @return True if any bit was added
+ */
+bool relaxPackedRow(uint64_t* edges, const uint64_t* pass, const uint64_t* neighbour, int words) {
+    uint64_t fresh = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t n = neighbour[w];
+        uint64_t left = (n << 1) | (w > 0 ? neighbour[w - 1] >> 63 : 0);
+        uint64_t right = (n >> 1) | (w + 1 < words ? neighbour[w + 1] << 63 : 0);
+        uint64_t grown = (n | left | right) & pass[w] & ~edges[w];
+        edges[w] |= grown;
+        fresh |= grown;
+    }
+    if (!fresh) return false;
+
+    fillPackedRow(edges, pass, words);
+    return true;
+}
+
+/**
+ * Hysteresis edge tracking on 64-bit packed rows
+ * 1. Pack strong pixels and passable (weak or strong) pixels into bit rows
+ * 2. Fill strong seeds along each row
+ * 3. Alternate top-down and bottom-up sweeps that pull edges from the
+ *    previous row until a full round adds nothing
+ *
+ * Every step handles 64 pixels per word without per-pixel branches. The
+ * number of rounds grows with how often an edge chain reverses vertical
+ * direction, so dense imagery benefits most while long spirals are the
+ * worst case.
+ *
+ * @param labels Label map (0 / EDGE_WEAK / EDGE_STRONG), updated in place
+ * @param workspace Holds the packed rows
+ */
+void EdgeDetector::trackEdgesBitParallel(cv::Mat& labels, EdgeWorkspace& workspace) {
+    const int rows = labels.rows;
+    const int cols = labels.cols;
+    const int words = (cols + 63) / 64;
+
+    std::vector<uint64_t>& edges = workspace.packedEdges;
+    std::vector<uint64_t>& pass = workspace.packedPass;
+    edges.assign(static_cast<size_t>(rows) * words, 0);
+    pass.assign(static_cast<size_t>(rows) * words, 0);
+
+    for (int y = 0; y < rows; y++) {
+        const uchar* row = labels.ptr<uchar>(y);
+        uint64_t* e = &edges[static_cast<size_t>(y) * words];
+        uint64_t* p = &pass[static_cast<size_t>(y) * words];
+
+        for (int x = 0; x < cols; x++) {
+            e[x >> 6] |= static_cast<uint64_t>(row[x] == EDGE_STRONG) << (x & 63);
+            p[x >> 6] |= static_cast<uint64_t>(row[x] != 0) << (x & 63);
+        }
+        fillPackedRow(e, p, words);
+    }
+
+    bool changed;
+    do {
+        changed = false;
+        for (int y = 1; y < rows; y++) {
+            changed |= relaxPackedRow(&edges[static_cast<size_t>(y) * words], &pass[static_cast<size_t>(y) * words],
+                                      &edges[static_cast<size_t>(y - 1) * words], words);
+        }
+        for (int y = rows - 2; y >= 0; y--) {
+            changed |= relaxPackedRow(&edges[static_cast<size_t>(y) * words], &pass[static_cast<size_t>(y) * words],
+                                      &edges[static_cast<size_t>(y + 1) * words], words);
+        }
+    } while (changed);
+
+    for (int y = 0; y < rows; y++) {
+        uchar* row = labels.ptr<uchar>(y);
+        const uint64_t* e = &edges[static_cast<size_t>(y) * words];
+        for (int x = 0; x < cols; x++) {
+            row[x] = static_cast<uchar>(-static_cast<int>((e[x >> 6] >> (x & 63)) & 1));
+        }
+    }
+}
+
+/**
+ * Grow edges from strong pixels through connected weak pixels
+ * @param labels Label map (0 / EDGE_WEAK / EDGE_STRONG), updated in place
+ * @param engine Hysteresis implementation to use
+ * @param workspace Scratch of the engine, reused across calls
+ * @param stripes Row stripes of the union-find engine, 0 for one per OpenCV thread
+ */
+void EdgeDetector::trackEdges(cv::Mat& labels, HysteresisEngine engine, EdgeWorkspace& workspace, int stripes) {
+    switch (engine) {
+        case HysteresisEngine::UnionFind:
+            trackEdgesUnionFind(labels, stripes, workspace);
+            break;
+        case HysteresisEngine::BitParallel:
+            trackEdgesBitParallel(labels, workspace);
+            break;
+        case HysteresisEngine::Worklist:
+        default:
+            trackEdgesWorklist(labels, workspace);
+            break;
+    }
+}
+
+/**
+ * Grow edges from strong pixels through connected weak pixels
+ * @param labels Label map (0 / EDGE_WEAK / EDGE_STRONG), updated in place
+ * @param engine Hysteresis implementation to use
+ * @param stripes Row stripes of the union-find engine, 0 for one per OpenCV thread
+ */
+void EdgeDetector::trackEdges(cv::Mat& labels, HysteresisEngine engine, int stripes) {
+    EdgeWorkspace workspace;
+    trackEdges(labels, engine, workspace, stripes);
+}
+
+/**
+ * Double thresholding
+ * Classify pixels as strong (>= high) or weak (>= low). Relative thresholds
+ * are scaled by the maximum suppressed magnitude, which needs a pass over
+ * the whole image first; absolute thresholds are used as they are. Weak
+ * pixels on the image border are never promoted by edge tracking, so they
+ * are not labelled weak in the first place.
+ *
+ * @param suppressed
+ * @param lowThreshold
+ * @param highThreshold
+ * @param mode Whether the thresholds are relative to the maximum or absolute
+ * @param stripes Number of row stripes run in parallel
+ * @param labels Output label map (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+void classifyInto(const cv::Mat& suppressed, float lowThreshold, float highThreshold, ThresholdMode mode,
+                  int stripes, cv::Mat& labels) {
+    float scale = 1.f;
+    if (mode == ThresholdMode::Relative) {
+        std::atomic<float> maxVal(0.f);
+        parallelStripes(cv::Range(0, suppressed.rows), [&](const cv::Range& range) {
+            double stripeMax;
+            cv::minMaxLoc(suppressed.rowRange(range.start, range.end), nullptr, &stripeMax);
+            atomicMax(maxVal, static_cast<float>(stripeMax));
+        }, stripes);
+        scale = maxVal.load();
+    }
+
+    float highThr = highThreshold * scale;
+    float lowThr = lowThreshold * scale;
+
+    labels.create(suppressed.size(), CV_8U);
+    parallelStripes(cv::Range(0, suppressed.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            EdgeDetector::classifyRow(suppressed.ptr<float>(y), suppressed.cols, lowThr, highThr,
+                        y > 0 && y < suppressed.rows - 1, labels.ptr<uchar>(y));
+        }
+    }, stripes);
+}
+
+/**
+ * Double thresholding into a fresh label map
+ * @param suppressed
+ * @param lowThreshold
+ * @param highThreshold
+ * @param mode Whether the thresholds are relative to the maximum or absolute
+ * @param stripes Number of row stripes run in parallel
+ * @return Label map (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+cv::Mat EdgeDetector::classifyEdges(const cv::Mat& suppressed, float lowThreshold, float highThreshold,
+                                    ThresholdMode mode, int stripes) {
+    cv::Mat labels;
+    classifyInto(suppressed, lowThreshold, highThreshold, mode, stripes, labels);
+    return labels;
+}
+
+/**
+ * Stop a call between two stages once its cancel flag is set
+ * Stages are never interrupted, so the workspace stays consistent and can
+ * be reused by the next call.
+ *
+ * @param params GradientParams of the call
+ */
+void throwIfCancelled(const GradientParams& params) {
+    if (params.cancel && params.cancel->load(std::memory_order_relaxed)) throw PipelineCancelled();
 }
 
 /**
@@ -251,50 +1446,121 @@ cv::Mat EdgeDetector::applySuppression(const GradientResult& gradients) {
  * @param suppressed
  * @param lowThreshold
  * @param highThreshold
+ * @param engine Hysteresis implementation to use
+ * @param mode Whether the thresholds are relative to the maximum or absolute
+ * @param stripes Number of row stripes used for classification and edge tracking
  */
 cv::Mat EdgeDetector::applyThresholding(const cv::Mat& suppressed,
-                                           float lowThreshold, float highThreshold) {
-    double maxVal;
-    cv::minMaxLoc(suppressed, nullptr, &maxVal);
+                                           float lowThreshold, float highThreshold,
+                                           HysteresisEngine engine, ThresholdMode mode, int stripes) {
+    cv::Mat labels = classifyEdges(suppressed, lowThreshold, highThreshold, mode, stripes);
+    trackEdges(labels, engine, stripes);
+    return labels;
+}
 
-    float highThr = highThreshold * maxVal;
-    float lowThr = lowThreshold * maxVal;
+/**
+ * Double thresholding and edge tracking of a suppressed map into reused
+ * buffers, the tail of process() on its own. A caller that keeps the
+ * suppressed map of an image can apply new thresholds without rerunning
+ * blur, gradients and suppression.
+ *
+ * @param suppressed Suppressed gradient magnitude, e.g. from suppress()
+ * @param params Thresholds, threshold mode, hysteresis engine, stripes and cancel flag; source is ignored
+ * @param edges Output edge map, reallocated only when its size or type differs
+ * @param workspace Edge tracking buffers, reused across calls
+ * @throws PipelineCancelled when params.cancel is set between the two stages
+ */
+void EdgeDetector::applyThresholding(const cv::Mat& suppressed, const GradientParams& params, cv::Mat& edges,
+                                     EdgeWorkspace& workspace) {
+    throwIfCancelled(params);
+    const int stripes = resolveStripes(params.stripes);
+    classifyInto(suppressed, params.lowThreshold, params.highThreshold, params.thresholdMode, stripes, edges);
+    throwIfCancelled(params);
+    trackEdges(edges, params.hysteresis, workspace, stripes);
+}
 
-    cv::Mat strong = cv::Mat::zeros(suppressed.size(), CV_8U);
-    cv::Mat weak = cv::Mat::zeros(suppressed.size(), CV_8U);
+/**
+ * Run the pipeline up to non-maximum suppression
+ * 1. Apply Gaussian blur
+ * 2. Compute gradients (magnitude and direction or sector)
+ * 3. Apply non-maximum suppression
+ * With tiled, all three steps run per L2-sized tile and only the
+ * suppressed map is materialised at full size.
+ *
+ * @param params GradientParams containing input image and parameters
+ * @param workspace Intermediate buffers, reused when the image size is unchanged
+ * @return Suppressed gradient magnitude, owned by the workspace
+ * @throws PipelineCancelled when params.cancel is set between two stages
+ */
+const cv::Mat& EdgeDetector::suppress(const GradientParams& params, EdgeWorkspace& workspace) {
+    int stripes = resolveStripes(params.stripes);
+    throwIfCancelled(params);
 
-    for (int y = 0; y < suppressed.rows; y++) {
-        for (int x = 0; x < suppressed.cols; x++) {
-            float val = suppressed.at<float>(y, x);
-            if (val >= highThr) strong.at<uchar>(y, x) = 255;
-            else if (val >= lowThr) weak.at<uchar>(y, x) = 255;
+    if (params.tiled) {
+        size_t tileBytes = 0;
+        createOutput(workspace.suppressed, params.source.rows, params.source.cols, CV_32F);
+        suppressTiles(params, stripes, false, tileBytes, workspace, workspace.suppressed);
+        if (params.stats) {
+            params.stats->intermediateBytes += matBytes(workspace.suppressed);
+            params.stats->tileBytes = tileBytes;
         }
+        return workspace.suppressed;
     }
 
-    cv::Mat edges = strong.clone();
+    blur(params, workspace);
+    if (params.stats) params.stats->intermediateBytes += matBytes(workspace.blurred);
+    return suppressBlurred(workspace.blurred, params, workspace);
+}
 
-    static constexpr int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
-    static constexpr int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+/**
+ * Apply the Gaussian blur of the pipeline on its own
+ * @param params GradientParams containing input image and parameters
+ * @param workspace Intermediate buffers, reused when the image size is unchanged
+ * @return CV_32F blurred image with the channels of the source, owned by the workspace
+ * @throws PipelineCancelled when params.cancel is set before the blur
+ */
+const cv::Mat& EdgeDetector::blur(const GradientParams& params, EdgeWorkspace& workspace) {
+    throwIfCancelled(params);
+    blurInto(params.source, params.sigma, resolveStripes(params.stripes), workspace);
+    return workspace.blurred;
+}
 
-    bool changed;
-    do {
-        changed = false;
-        for (int y = 1; y < edges.rows - 1; y++) {
-            for (int x = 1; x < edges.cols - 1; x++) {
-                if (weak.at<uchar>(y, x) == 255 && edges.at<uchar>(y, x) == 0) {
-                    for (int i = 0; i < 8; i++) {
-                        if (edges.at<uchar>(y + dy[i], x + dx[i]) == 255) {
-                            edges.at<uchar>(y, x) = 255;
-                            changed = true;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    } while (changed);
+/**
+ * Run gradients and non-maximum suppression on an image that is already
+ * blurred, e.g. by blur(). Since blur and colour conversion are both
+ * linear, a gray input can be derived from a blurred color image instead
+ * of being blurred on its own; the result then differs from suppress()
+ * only by the 8-bit rounding of the two blurs.
+ *
+ * @param blurred CV_32FC1 image, or CV_32FC3 when params.isColor; may be the workspace's own blurred image
+ * @param params Direction encoding, stripes, stats and cancel flag; source and sigma are ignored
+ * @param workspace Intermediate buffers, reused when the image size is unchanged
+ * @return Suppressed gradient magnitude, owned by the workspace
+ * @throws PipelineCancelled when params.cancel is set between two stages
+ */
+const cv::Mat& EdgeDetector::suppressBlurred(const cv::Mat& blurred, const GradientParams& params,
+                                             EdgeWorkspace& workspace) {
+    int stripes = resolveStripes(params.stripes);
+    const GradientResult& gradients = workspace.gradients;
+    throwIfCancelled(params);
+    computeGradients(blurred, params.isColor, params.directionEncoding, stripes, workspace.gradients);
+    throwIfCancelled(params);
+    suppressInto(gradients, stripes, workspace.sector, workspace.suppressed);
+    if (params.stats) {
+        params.stats->intermediateBytes += matBytes(gradients.magnitude) + matBytes(gradients.direction)
+                                         + matBytes(gradients.sector) + matBytes(workspace.suppressed);
+    }
+    return workspace.suppressed;
+}
 
-    return edges;
+/**
+ * Run the pipeline up to non-maximum suppression with fresh buffers
+ * @param params GradientParams containing input image and parameters
+ * @return Suppressed gradient magnitude
+ */
+cv::Mat EdgeDetector::suppress(const GradientParams& params) {
+    EdgeWorkspace workspace;
+    return suppress(params, workspace);
 }
 
 /**
@@ -303,13 +1569,108 @@ cv::Mat EdgeDetector::applyThresholding(const cv::Mat& suppressed,
  * 2. Compute gradients (magnitude and direction)
  * 3. Apply non-maximum suppression
  * 4. Apply double thresholding and edge tracking
+ * With fuseClassification, steps 3 and 4 share one pass that writes the
+ * label map directly. With tiled, steps 1 to 3 run per tile instead.
+ * Relative thresholds need the global maximum, so classification follows
+ * as its own pass; absolute thresholds let fuseClassification label each
+ * tile while it is still in cache.
+ *
+ * Every stage runs over horizontal stripes in parallel, with
+ * a barrier between stages so each stripe can read its halo rows from the
+ * previous stage. The output does not depend on the number of stripes.
+ * Edge tracking is parallel with HysteresisEngine::UnionFind.
  *
+ * All intermediates live in the workspace and edges is written in place.
+ * Mat::create and the vectors keep their storage when the size is
+ * unchanged, so once a workspace has seen an image size, later calls of
+ * that size with the same parameters allocate nothing.
+ *
+ * A set params.cancel abandons the call at the next stage boundary with
+ * PipelineCancelled, leaving edges unspecified.
+ *
+ * @param params GradientParams containing input image and parameters
+ * @param edges Output edge map, reallocated only when its size or type differs
+ * @param workspace Intermediate buffers, reused across calls
+ * @throws PipelineCancelled when params.cancel is set between two stages
+ */
+void EdgeDetector::process(const GradientParams& params, cv::Mat& edges, EdgeWorkspace& workspace) {
+    int stripes = resolveStripes(params.stripes);
+    throwIfCancelled(params);
+
+    if (params.fuseClassification && params.tiled && params.thresholdMode == ThresholdMode::Absolute) {
+        size_t tileBytes = 0;
+        suppressTiles(params, stripes, true, tileBytes, workspace, edges);
+        if (params.stats) params.stats->tileBytes = tileBytes;
+        throwIfCancelled(params);
+        trackEdges(edges, params.hysteresis, workspace, stripes);
+        return;
+    }
+
+    if (params.fuseClassification && !params.tiled) {
+        const GradientResult& gradients = workspace.gradients;
+        blurInto(params.source, params.sigma, stripes, workspace);
+        throwIfCancelled(params);
+        computeGradients(workspace.blurred, params.isColor, params.directionEncoding, stripes, workspace.gradients);
+        throwIfCancelled(params);
+        suppressAndClassifyInto(gradients, params.lowThreshold, params.highThreshold, params.thresholdMode, stripes,
+                                workspace, edges);
+        if (params.stats) {
+            params.stats->intermediateBytes += matBytes(workspace.blurred) + matBytes(gradients.magnitude)
+                                             + matBytes(gradients.direction) + matBytes(gradients.sector);
+        }
+        throwIfCancelled(params);
+        trackEdges(edges, params.hysteresis, workspace, stripes);
+        return;
+    }
+
+    applyThresholding(suppress(params, workspace), params, edges, workspace);
+}
+
+/**
+ * Canny edge detection with buffers allocated for this call only
  * @param params GradientParams containing input image and parameters
  * @return Processed image with edges detected
  */
 cv::Mat EdgeDetector::process(const GradientParams& params) {
-    auto blurred = applyGaussianBlur(params.source, params.sigma);
-    auto gradients = computeGradients(blurred, params.isColor);
-    auto suppressed = applySuppression(gradients);
-    return applyThresholding(suppressed, params.lowThreshold, params.highThreshold);
-}
\ No newline at end of file
+    EdgeWorkspace workspace;
+    cv::Mat edges;
+    process(params, edges, workspace);
+    return edges;
+}
+
+/**
+ * Canny edge detection for a batch of images
+ * Every image is a task on the shared WorkerPool, largest first. Images
+ * below BATCH_SPLIT_PIXELS run whole with a single stripe, so they never
+ * pay for stripe barriers. Larger images fork their stages into one
+ * stripe per worker onto the deque of the worker running them, and idle
+ * workers steal those stripes, so a few giants among many thumbnails do
+ * not leave the pool waiting on one core. Each worker keeps one
+ * workspace. Each edge map matches process() for the same parameters.
+ *
+ * @param batch GradientParams of each image
+ * @param stats Optional; receives the wall time and per-worker counters of the batch
+ * @return Edge maps in input order
+ */
+std::vector<cv::Mat> EdgeDetector::processBatch(const std::vector<GradientParams>& batch, PoolStats* stats) {
+    std::vector<cv::Mat> results(batch.size());
+    std::vector<int> order(batch.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return batch[a].source.total() > batch[b].source.total();
+    });
+
+    WorkerPool& pool = WorkerPool::shared();
+    std::vector<EdgeWorkspace> workspaces(pool.size());
+
+    // A worker never starts another image while its own is in progress,
+    // so one workspace per worker is enough
+    WorkerPool::Task task = [&](int index, int worker) {
+        GradientParams params = batch[order[index]];
+        if (params.source.total() < BATCH_SPLIT_PIXELS) params.stripes = 1;
+        else if (params.stripes <= 0) params.stripes = pool.size();
+        process(params, results[order[index]], workspaces[worker]);
+    };
+    pool.run(static_cast<int>(order.size()), task, stats);
+    return results;
+}
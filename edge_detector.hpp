@@ -2,6 +2,33 @@
 #define EDGE_DETECTOR_HPP
 
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+struct PoolStats;
+
+enum class HysteresisEngine {
+    Worklist,   // Serial stack-based edge tracking
+    UnionFind,  // Parallel connected components over row stripes, below 2^31 - 1 pixels
+    BitParallel // 64-bit packed rows grown with word-wide dilation
+};
+
+enum class DirectionEncoding {
+    Radians,    // CV_32F gradient direction
+    Sector      // CV_8U non-maximum suppression sector (0-3)
+};
+
+enum class ThresholdMode {
+    Relative,   // Fractions of the maximum suppressed magnitude
+    Absolute    // Gradient magnitude values, no global maximum needed
+};
+
+struct PipelineStats {
+    size_t intermediateBytes = 0;  // Full-size Mats handed between stages
+    size_t tileBytes = 0;          // Scratch of one tile when tiled
+};
 
 struct GradientParams {
     cv::Mat source;
@@ -9,25 +36,107 @@ struct GradientParams {
     float lowThreshold;
     float highThreshold;
     bool isColor;
+    ThresholdMode thresholdMode = ThresholdMode::Relative;
+    HysteresisEngine hysteresis = HysteresisEngine::Worklist;
+    DirectionEncoding directionEncoding = DirectionEncoding::Sector;
+    bool fuseClassification = false;   // NMS writes the label map directly
+    int stripes = 0;                   // Row stripes per stage, 0 = one per OpenCV thread
+    bool tiled = false;                // Blur, gradients and NMS per cache-resident tile
+    int tileRows = 0;                  // Rows per tile, 0 = sized to fit L2
+    PipelineStats* stats = nullptr;    // Accumulates intermediate traffic when set
+    const std::atomic<bool>* cancel = nullptr;  // Abandons the call at the next stage once set
+};
+
+// Thrown by a call whose cancel flag was set before it finished
+class PipelineCancelled : public std::runtime_error {
+public:
+    PipelineCancelled() : std::runtime_error("Edge detection cancelled") {}
 };
 
 struct GradientResult {
     cv::Mat magnitude;
-    cv::Mat direction;
+    cv::Mat direction;  // DirectionEncoding::Radians
+    cv::Mat sector;     // DirectionEncoding::Sector
+    float maxMagnitude = 0;  // Largest magnitude away from the image border
+};
+
+struct EdgeWorkspace {
+    struct Stripe {
+        cv::Mat blurred8;              // 8-bit blurred rows of a stripe or tile with their halo
+        cv::Mat blurred;               // CV_32F blurred rows of a tile
+        cv::Mat magnitude;             // Magnitude rows of a tile
+        cv::Mat sector;                // Sector rows of a tile
+        std::vector<float> direction;  // Radian direction row of a tile
+        std::vector<float> row;        // Suppressed row classified in place
+    };
+
+    cv::Mat blurred;
+    GradientResult gradients;
+    cv::Mat sector;                    // Sector map quantised from a radian direction
+    cv::Mat suppressed;                // Default allocator, callers may keep it
+    std::vector<Stripe> stripes;
+    std::vector<cv::Point> stack;      // HysteresisEngine::Worklist
+    std::unique_ptr<std::atomic<int>[]> parent;  // HysteresisEngine::UnionFind
+    size_t parentSize = 0;
+    std::vector<uint64_t> packedEdges; // HysteresisEngine::BitParallel
+    std::vector<uint64_t> packedPass;
 };
 
 class EdgeDetector {
 public:
+    static constexpr uchar EDGE_WEAK = 128;
+    static constexpr uchar EDGE_STRONG = 255;
+    // Images of at least this many pixels are split into stripes in a
+    // batch; smaller ones run whole, one per thread
+    static constexpr size_t BATCH_SPLIT_PIXELS = 1 << 20;
+
     static cv::Mat process(const GradientParams& params);
+    static void process(const GradientParams& params, cv::Mat& edges, EdgeWorkspace& workspace);
+    static std::vector<cv::Mat> processBatch(const std::vector<GradientParams>& batch, PoolStats* stats = nullptr);
+    static cv::Mat suppress(const GradientParams& params);
+    static const cv::Mat& suppress(const GradientParams& params, EdgeWorkspace& workspace);
+    static const cv::Mat& blur(const GradientParams& params, EdgeWorkspace& workspace);
+    static const cv::Mat& suppressBlurred(const cv::Mat& blurred, const GradientParams& params,
+                                          EdgeWorkspace& workspace);
+    static cv::Mat applyGaussianBlur(const cv::Mat& source, double sigma, int stripes = 1);
+    static GradientResult computeGradients(const cv::Mat& image, bool isColor, DirectionEncoding encoding,
+                                           int stripes = 1);
+    static cv::Mat applySuppression(const GradientResult& gradients, int stripes = 1);
+    static void computeGradientRow(const float* up, const float* mid, const float* down, int cols, bool isColor,
+                                   float* magnitude, uchar* sector);
+    static void suppressGradientRow(const float* up, const float* mid, const float* down, const uchar* sector,
+                                    int cols, float* suppressed);
+    static void classifyRow(const float* src, int cols, float lowThr, float highThr, bool interiorRow, uchar* dst,
+                            bool leftBorder = true, bool rightBorder = true);
+    static cv::Mat suppressAndClassify(const GradientResult& gradients, float lowThreshold, float highThreshold,
+                                       ThresholdMode mode = ThresholdMode::Relative, int stripes = 1);
+    static cv::Mat applyThresholding(const cv::Mat& suppressed, float lowThreshold, float highThreshold,
+                                     HysteresisEngine engine, ThresholdMode mode = ThresholdMode::Relative,
+                                     int stripes = 1);
+    static void applyThresholding(const cv::Mat& suppressed, const GradientParams& params, cv::Mat& edges,
+                                  EdgeWorkspace& workspace);
+    static cv::Mat classifyEdges(const cv::Mat& suppressed, float lowThreshold, float highThreshold,
+                                 ThresholdMode mode = ThresholdMode::Relative, int stripes = 1);
+    static void trackEdges(cv::Mat& labels, HysteresisEngine engine, int stripes = 0);
+    static void trackEdges(cv::Mat& labels, HysteresisEngine engine, EdgeWorkspace& workspace, int stripes = 0);
 
-private:
     static int calculateGaussianKernelSize(double sigma);
-    static cv::Mat applyGaussianBlur(const cv::Mat& source, double sigma);
-    static GradientResult computeGradients(const cv::Mat& image, bool isColor);
-    static GradientResult computeGrayGradients(const cv::Mat& image);
-    static GradientResult computeColorGradients(const cv::Mat& image);
-    static cv::Mat applySuppression(const GradientResult& gradients);
-    static cv::Mat applyThresholding(const cv::Mat& suppressed, float lowThreshold, float highThreshold);
+    static void setIntermediateAllocator(cv::MatAllocator* allocator);
+
+private:
+    static int resolveStripes(int stripes);
+    static int calculateTileRows(int cols, int channels, int radius);
+    static void suppressTiles(const GradientParams& params, int stripes, bool classify, size_t& tileBytes,
+                              EdgeWorkspace& workspace, cv::Mat& dst);
+    static void computeGradients(const cv::Mat& image, bool isColor, DirectionEncoding encoding, int stripes,
+                                 GradientResult& result);
+    static void computeGrayGradients(const cv::Mat& image, DirectionEncoding encoding, int stripes,
+                                     GradientResult& result);
+    static void computeColorGradients(const cv::Mat& image, DirectionEncoding encoding, int stripes,
+                                      GradientResult& result);
+    static void trackEdgesWorklist(cv::Mat& labels, EdgeWorkspace& workspace);
+    static void trackEdgesUnionFind(cv::Mat& labels, int stripes, EdgeWorkspace& workspace);
+    static void trackEdgesBitParallel(cv::Mat& labels, EdgeWorkspace& workspace);
 };
 
 #endif // EDGE_DETECTOR_HPP
\ No newline at end of file
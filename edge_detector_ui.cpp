@@ -1,8 +1,28 @@
 #include "edge_detector_ui.hpp"
+#include "worker_pool.hpp"
+#include <cstdlib>
 #include <filesystem>
+#include <iomanip>
+#include <iostream>
 #include <sstream>
+#if defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
-EdgeDetectorUI::EdgeDetectorUI(const std::string& imagePath) {
+// Let the OS schedule the calling thread behind interactive work
+static void lowerThreadPriority() {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+EdgeDetectorUI::EdgeDetectorUI(const std::string& imagePath, size_t sigmaCacheBytes) : cacheLimit(sigmaCacheBytes) {
     if (imagePath.empty()) {
         if (!loadImage(selectImageFile())) {
             throw std::runtime_error("No image selected or invalid image");
@@ -14,12 +34,19 @@ EdgeDetectorUI::EdgeDetectorUI(const std::string& imagePath) {
     }
 }
 
+EdgeDetectorUI::~EdgeDetectorUI() {
+    stopWorker();
+}
+
 bool EdgeDetectorUI::loadImage(const std::string& imagePath) {
     originalImage = cv::imread(imagePath, cv::IMREAD_COLOR);
     if (originalImage.empty()) {
         return false;
     }
     cv::cvtColor(originalImage, grayImage, cv::COLOR_BGR2GRAY);
+    grayMode.sigmaValue = -1;
+    colorMode.sigmaValue = -1;
+    cache = SigmaCache();
     return true;
 }
 
@@ -58,44 +85,306 @@ void EdgeDetectorUI::createWindows() {
 
 void EdgeDetectorUI::trackbarCallback(int, void* userdata) {
     auto* ui = static_cast<EdgeDetectorUI*>(userdata);
-    ui->updateDisplay();
+    ui->requestUpdate();
+}
+
+// Post the current trackbar values to the recompute worker. A frame still
+// in progress is cancelled, so a drag only ever computes its latest state.
+void EdgeDetectorUI::requestUpdate() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requested = params;
+        requestedGeneration++;
+        cancel = true;
+    }
+    wake.notify_one();
+}
+
+// Recompute worker: wait for a request, compute it, and publish the frame
+// unless a newer request arrived meanwhile
+void EdgeDetectorUI::recomputeLoop() {
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake.wait(lock, [&] { return stopping || requestedGeneration != seen; });
+        if (stopping) return;
+        seen = requestedGeneration;
+        Parameters parameters = requested;
+        cancel = false;
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> cacheLock(cacheMutex);
+            cache.focus = parameters.sigmaValue;
+            cache.sharedBlur = parameters.sharedBlur != 0;
+            recomputing = true;
+            precomputeCancel = true;
+        }
+
+        Frame frame;
+        try {
+            frame = processImages(parameters);
+        } catch (const PipelineCancelled&) {
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> cacheLock(cacheMutex);
+            recomputing = false;
+        }
+        precomputeWake.notify_one();
+
+        lock.lock();
+        if (!frame.display.empty() && seen == requestedGeneration) {
+            finished = std::move(frame);
+            frameReady = true;
+        }
+    }
+}
+
+// Precompute worker: suppress the missing sigma level nearest the slider,
+// one level at a time on a single stripe, until the cache is full or holds
+// every level. It waits while a recompute runs, and a cancelled level is
+// simply picked again later. A gray level derived from the color blur also
+// suppresses the color level from that blur when it is missing.
+void EdgeDetectorUI::precomputeLoop() {
+    lowerThreadPriority();
+    EdgeWorkspace workspace;
+    cv::Mat grayBlurred;
+    size_t mapBytes = originalImage.total() * sizeof(float);
+    std::unique_lock<std::mutex> lock(cacheMutex);
+
+    while (true) {
+        int pipeline = GRAY;
+        int sigmaValue = 0;
+        precomputeWake.wait(lock, [&] {
+            return precomputeStopping || (!recomputing && nextPrecompute(mapBytes, pipeline, sigmaValue));
+        });
+        if (precomputeStopping) return;
+        precomputeCancel = false;
+        bool colorMissing = !cache.levels[COLOR].count(sigmaValue);
+        lock.unlock();
+
+        GradientParams detection;
+        detection.source = pipeline == GRAY ? grayImage : originalImage;
+        detection.sigma = static_cast<double>(sigmaValue) / 10.0;
+        detection.lowThreshold = 0;
+        detection.highThreshold = 0;
+        detection.isColor = pipeline == COLOR;
+        detection.stripes = 1;
+        detection.cancel = &precomputeCancel;
+        cv::Mat suppressed, colorSuppressed;
+        try {
+            if (pipeline == GRAY_FROM_COLOR_BLUR) {
+                GradientParams color = detection;
+                color.isColor = true;
+                cv::cvtColor(EdgeDetector::blur(color, workspace), grayBlurred, cv::COLOR_BGR2GRAY);
+                suppressed = EdgeDetector::suppressBlurred(grayBlurred, detection, workspace);
+                workspace.suppressed = cv::Mat();   // Owned by the cache from now on
+                if (colorMissing) {
+                    colorSuppressed = EdgeDetector::suppressBlurred(workspace.blurred, color, workspace);
+                    workspace.suppressed = cv::Mat();
+                }
+            } else {
+                suppressed = EdgeDetector::suppress(detection, workspace);
+                workspace.suppressed = cv::Mat();
+            }
+        } catch (const PipelineCancelled&) {
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+
+        lock.lock();
+        if (!suppressed.empty()) cacheSuppressed(pipeline, sigmaValue, suppressed);
+        if (!colorSuppressed.empty()) cacheSuppressed(COLOR, sigmaValue, colorSuppressed);
+    }
+}
+
+void EdgeDetectorUI::stopWorker() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            cancel = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+    if (precomputer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            precomputeStopping = true;
+            precomputeCancel = true;
+        }
+        precomputeWake.notify_one();
+        precomputer.join();
+    }
+}
+
+// Cached suppressed map of a pipeline and sigma position, empty on a miss
+cv::Mat EdgeDetectorUI::cachedSuppressed(int pipeline, int sigmaValue) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto level = cache.levels[pipeline].find(sigmaValue);
+    return level != cache.levels[pipeline].end() ? level->second : cv::Mat();
+}
+
+// Missing level nearest the slider, of the gray pipeline the newest request
+// shows before color at equal distance. False when every level is cached
+// or the nearest missing one does not fit; a farther level would not fit
+// either. Called with cacheMutex held.
+bool EdgeDetectorUI::nextPrecompute(size_t mapBytes, int& pipeline, int& sigmaValue) const {
+    int gray = cache.sharedBlur ? GRAY_FROM_COLOR_BLUR : GRAY;
+    for (int distance = 0; distance < SIGMA_LEVELS; distance++) {
+        for (int level : {cache.focus - distance, cache.focus + distance}) {
+            if (level < 0 || level >= SIGMA_LEVELS) continue;
+            for (int candidate : {gray, static_cast<int>(COLOR)}) {
+                if (cache.levels[candidate].count(level)) continue;
+                pipeline = candidate;
+                sigmaValue = level;
+                return canCache(level, mapBytes);
+            }
+        }
+    }
+    return false;
+}
+
+// Whether a map fits under the cap once levels strictly farther from the
+// slider are evicted. Called with cacheMutex held.
+bool EdgeDetectorUI::canCache(int sigmaValue, size_t mapBytes) const {
+    int distance = std::abs(sigmaValue - cache.focus);
+    size_t kept = cache.bytes;
+    for (const std::map<int, cv::Mat>& levels : cache.levels) {
+        for (const auto& [level, suppressed] : levels) {
+            if (std::abs(level - cache.focus) > distance) kept -= suppressed.total() * suppressed.elemSize();
+        }
+    }
+    return kept + mapBytes <= cacheLimit;
+}
+
+// Add a map to the cache, evicting the levels farthest from the slider
+// until it fits; dropped when it would not fit. Called with cacheMutex held.
+void EdgeDetectorUI::cacheSuppressed(int pipeline, int sigmaValue, const cv::Mat& suppressed) {
+    size_t mapBytes = suppressed.total() * suppressed.elemSize();
+    if (cache.levels[pipeline].count(sigmaValue) || !canCache(sigmaValue, mapBytes)) return;
+
+    while (cache.bytes + mapBytes > cacheLimit) {
+        std::map<int, cv::Mat>* farthestLevels = nullptr;
+        int farthest = -1;
+        for (std::map<int, cv::Mat>& levels : cache.levels) {
+            for (const auto& [level, entry] : levels) {
+                if (!farthestLevels || std::abs(level - cache.focus) > std::abs(farthest - cache.focus)) {
+                    farthestLevels = &levels;
+                    farthest = level;
+                }
+            }
+        }
+        const cv::Mat& evicted = farthestLevels->at(farthest);
+        cache.bytes -= evicted.total() * evicted.elemSize();
+        farthestLevels->erase(farthest);
+    }
+
+    cache.levels[pipeline].emplace(sigmaValue, suppressed);
+    cache.bytes += mapBytes;
 }
 
 void EdgeDetectorUI::createTrackbars() {
     cv::createTrackbar("Low Threshold (%)", "Parameters", &params.lowThresholdRatio, 100, trackbarCallback, this);
     cv::createTrackbar("High Threshold (%)", "Parameters", &params.highThresholdRatio, 100, trackbarCallback, this);
-    cv::createTrackbar("Sigma (x10)", "Parameters", &params.sigmaValue, 50, trackbarCallback, this);
+    cv::createTrackbar("Sigma (x10)", "Parameters", &params.sigmaValue, SIGMA_LEVELS - 1, trackbarCallback, this);
+    cv::createTrackbar("Shared Blur", "Parameters", &params.sharedBlur, 1, trackbarCallback, this);
+}
+
+// Point a mode at its last or a cached suppressed map of a pipeline and
+// sigma position. Holding the map keeps it valid even if it is evicted.
+// False when it has to be suppressed.
+bool EdgeDetectorUI::reuseSuppressed(ModeState& mode, int pipeline, int sigmaValue) {
+    if (mode.pipeline == pipeline && mode.sigmaValue == sigmaValue) return true;
+    cv::Mat cached = cachedSuppressed(pipeline, sigmaValue);
+    if (cached.empty()) return false;
+    mode.suppressed = cached;
+    mode.pipeline = pipeline;
+    mode.sigmaValue = sigmaValue;
+    return true;
 }
 
-void EdgeDetectorUI::processImages() {
-    float lowThr = static_cast<float>(params.lowThresholdRatio) / 100.0f;
-    float highThr = static_cast<float>(params.highThresholdRatio) / 100.0f;
-    double sigma = static_cast<double>(params.sigmaValue) / 10.0;
+// Edge map of one colour mode. Blur, gradients and suppression depend only
+// on the image, the pipeline and sigma, so the suppressed map is memoized
+// per sigma and a threshold change reruns only classification and edge
+// tracking. A sigma change is a cache lookup once the precompute worker
+// has reached it. A non-empty blurred input skips the blur.
+const cv::Mat& EdgeDetectorUI::detectEdges(ModeState& mode, const GradientParams& detection, int pipeline,
+                                           int sigmaValue, const cv::Mat& blurred) {
+    if (!reuseSuppressed(mode, pipeline, sigmaValue)) {
+        mode.sigmaValue = -1;           // A cancelled suppress leaves the map incomplete
+        // Hand the map to the cache instead of copying it
+        mode.suppressed = blurred.empty() ? EdgeDetector::suppress(detection, mode.workspace)
+                                          : EdgeDetector::suppressBlurred(blurred, detection, mode.workspace);
+        mode.workspace.suppressed = cv::Mat();
+        mode.pipeline = pipeline;
+        mode.sigmaValue = sigmaValue;
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cacheSuppressed(pipeline, sigmaValue, mode.suppressed);
+    }
+    EdgeDetector::applyThresholding(mode.suppressed, detection, mode.edges, mode.workspace);
+    return mode.edges;
+}
 
-    // Process images
-    cv::Mat grayEdges = EdgeDetector::process({
-        .source = grayImage,
-        .sigma = sigma,
-        .lowThreshold = lowThr,
-        .highThreshold = highThr,
-        .isColor = false
-    });
+EdgeDetectorUI::Frame EdgeDetectorUI::processImages(const Parameters& parameters) {
+    float lowThr = static_cast<float>(parameters.lowThresholdRatio) / 100.0f;
+    float highThr = static_cast<float>(parameters.highThresholdRatio) / 100.0f;
+    double sigma = static_cast<double>(parameters.sigmaValue) / 10.0;
+    bool sharedBlur = parameters.sharedBlur != 0;
+    int grayPipeline = sharedBlur ? GRAY_FROM_COLOR_BLUR : GRAY;
 
-    cv::Mat colorEdges = EdgeDetector::process({
-        .source = originalImage,
-        .sigma = sigma,
-        .lowThreshold = lowThr,
-        .highThreshold = highThr,
-        .isColor = true
+    auto detection = [&](bool isColor) {
+        GradientParams params;
+        params.source = isColor ? originalImage : grayImage;
+        params.sigma = sigma;
+        params.lowThreshold = lowThr;
+        params.highThreshold = highThr;
+        params.isColor = isColor;
+        params.cancel = &cancel;
+        return params;
+    };
+
+    // With the shared blur, the gray input is the gray conversion of the
+    // blurred color image. Blur and BGR to gray are both linear, so this
+    // matches blurring the gray image up to 8-bit rounding, and one color
+    // blur serves both pipelines when both need suppressing.
+    cv::TickMeter grayTime, colorTime, bothTime;
+    bothTime.start();
+    cv::Mat colorBlurred, grayBlurred;
+    if (sharedBlur && !reuseSuppressed(grayMode, grayPipeline, parameters.sigmaValue)) {
+        colorBlurred = EdgeDetector::blur(detection(true), colorMode.workspace);
+        cv::cvtColor(colorBlurred, grayBlurred, cv::COLOR_BGR2GRAY);
+    }
+
+    // Process both images as concurrent pool tasks, abandoned between
+    // stages once a newer request arrives. Their stripes are stolen by
+    // whichever worker is idle, so the shorter gray run does not leave
+    // cores waiting on the color one.
+    WorkerPool::shared().run(2, [&](int index, int) {
+        bool isColor = index == 1;
+        cv::TickMeter& time = isColor ? colorTime : grayTime;
+        time.start();
+        detectEdges(isColor ? colorMode : grayMode, detection(isColor), isColor ? COLOR : grayPipeline,
+                    parameters.sigmaValue, isColor ? colorBlurred : grayBlurred);
+        time.stop();
     });
+    bothTime.stop();
+    const cv::Mat& grayEdges = grayMode.edges;
+    const cv::Mat& colorEdges = colorMode.edges;
 
     // Create display
     int rows = originalImage.rows;
     int cols = originalImage.cols;
-    display = cv::Mat(rows + LABEL_HEIGHT, cols * 3, CV_8UC3, cv::Scalar(0, 0, 0));
+    Frame frame;
+    frame.display = cv::Mat(rows + LABEL_HEIGHT, cols * 3, CV_8UC3, cv::Scalar(0, 0, 0));
 
-    cv::Mat labelRegion = display(cv::Rect(0, 0, cols * 3, LABEL_HEIGHT));
-    cv::Mat imageRegion = display(cv::Rect(0, LABEL_HEIGHT, cols * 3, rows));
+    cv::Mat labelRegion = frame.display(cv::Rect(0, 0, cols * 3, LABEL_HEIGHT));
+    cv::Mat imageRegion = frame.display(cv::Rect(0, LABEL_HEIGHT, cols * 3, rows));
 
     // Add labels
     cv::putText(labelRegion, "Original", cv::Point(cols/3, 20),
@@ -119,9 +408,15 @@ void EdgeDetectorUI::processImages() {
 
     // Update parameters banner
     std::stringstream ss;
-    ss << "Low Threshold: " << lowThr << " | High Threshold: " << highThr << " | Sigma: " << sigma;
-    banner = cv::Mat(LABEL_HEIGHT, cols * 3, CV_8UC3, cv::Scalar(0, 0, 0));
-    cv::putText(banner, ss.str(), cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+    // Wall times only: the two tasks share the pool and run each other's
+    // stripes, so their sum is no sequential baseline
+    ss << "Low Threshold: " << lowThr << " | High Threshold: " << highThr << " | Sigma: " << sigma
+       << (sharedBlur ? " (shared blur)" : "") << std::fixed << std::setprecision(1)
+       << " | Gray " << grayTime.getTimeMilli() << " ms, Color " << colorTime.getTimeMilli()
+       << " ms, both " << bothTime.getTimeMilli() << " ms";
+    frame.banner = cv::Mat(LABEL_HEIGHT, cols * 3, CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::putText(frame.banner, ss.str(), cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+    return frame;
 }
 
 void EdgeDetectorUI::displayResults() {
@@ -129,15 +424,13 @@ void EdgeDetectorUI::displayResults() {
     cv::imshow("Parameters", banner);
 }
 
-void EdgeDetectorUI::updateDisplay() {
-    processImages();
-    displayResults();
-}
-
 void EdgeDetectorUI::run() {
     createWindows();
     createTrackbars();
-    updateDisplay();
+    cache.focus = params.sigmaValue;
+    worker = std::thread(&EdgeDetectorUI::recomputeLoop, this);
+    precomputer = std::thread(&EdgeDetectorUI::precomputeLoop, this);
+    requestUpdate();
 
     std::cout << "Press 'q' to exit" << std::endl;
 
@@ -145,5 +438,17 @@ void EdgeDetectorUI::run() {
         char key = static_cast<char>(cv::waitKey(30));
         if (key == 'q' || key == 27)
             break;
+
+        // Show the newest finished frame, if any arrived since the last key poll
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!frameReady) continue;
+            display = std::move(finished.display);
+            banner = std::move(finished.banner);
+            frameReady = false;
+        }
+        displayResults();
     }
+
+    stopWorker();
 }
\ No newline at end of file
@@ -3,21 +3,80 @@
 
 #include "edge_detector.hpp"
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 
 class EdgeDetectorUI {
 public:
-    explicit EdgeDetectorUI(const std::string& imagePath = "");
+    static constexpr size_t DEFAULT_SIGMA_CACHE_BYTES = size_t(1) << 30;
+
+    explicit EdgeDetectorUI(const std::string& imagePath = "", size_t sigmaCacheBytes = DEFAULT_SIGMA_CACHE_BYTES);
+    ~EdgeDetectorUI();
     void run();
 
 private:
+    struct Parameters {
+        int lowThresholdRatio = 5;
+        int highThresholdRatio = 15;
+        int sigmaValue = 4;
+        int sharedBlur = 0;             // 1: the gray input is derived from the color blur
+    };
+
+    // Pipelines whose suppressed maps differ, cached separately
+    enum Pipeline {
+        GRAY,
+        COLOR,
+        GRAY_FROM_COLOR_BLUR,           // Gray conversion of the blurred color image
+        PIPELINES
+    };
+
+    // A composed comparison and its parameters banner
+    struct Frame {
+        cv::Mat display;
+        cv::Mat banner;
+    };
+
+    // Pipeline state of one colour mode, reused by every recompute so
+    // trackbar drags do not reallocate
+    struct ModeState {
+        EdgeWorkspace workspace;
+        cv::Mat edges;
+        cv::Mat suppressed;             // Suppressed map of the last recompute
+        int pipeline = GRAY;            // Pipeline of suppressed
+        int sigmaValue = -1;            // Sigma of suppressed, -1 for none
+    };
+
+    // Suppressed maps by pipeline and sigma trackbar position, filled by
+    // the recompute and precompute workers under a memory cap. Levels
+    // nearest the slider are computed first and evicted last.
+    struct SigmaCache {
+        std::map<int, cv::Mat> levels[PIPELINES];
+        size_t bytes = 0;
+        int focus = 0;                      // Sigma trackbar position of the newest request
+        bool sharedBlur = false;            // Shared blur setting of the newest request
+    };
+
     bool loadImage(const std::string& imagePath);
     std::string selectImageFile();
 
     static void trackbarCallback(int, void* userdata);
-    void updateDisplay();
+    void requestUpdate();
+    void recomputeLoop();
+    void precomputeLoop();
+    void stopWorker();
+    cv::Mat cachedSuppressed(int pipeline, int sigmaValue);
+    bool nextPrecompute(size_t mapBytes, int& pipeline, int& sigmaValue) const;
+    bool canCache(int sigmaValue, size_t mapBytes) const;
+    void cacheSuppressed(int pipeline, int sigmaValue, const cv::Mat& suppressed);
     void createWindows();
     void createTrackbars();
-    void processImages();
+    Frame processImages(const Parameters& parameters);
+    bool reuseSuppressed(ModeState& mode, int pipeline, int sigmaValue);
+    const cv::Mat& detectEdges(ModeState& mode, const GradientParams& detection, int pipeline, int sigmaValue,
+                               const cv::Mat& blurred);
     void displayResults();
 
     cv::Mat originalImage;
@@ -25,13 +84,37 @@ private:
     cv::Mat display;
     cv::Mat banner;
 
-    struct Parameters {
-        int lowThresholdRatio = 5;
-        int highThresholdRatio = 15;
-        int sigmaValue = 4;
-    } params;
+    // Only the recompute worker touches these
+    ModeState grayMode;
+    ModeState colorMode;
+
+    Parameters params;                  // Bound to the trackbars, GUI thread only
+
+    // Recompute worker: the GUI thread posts the newest parameters and
+    // cancels the frame in progress, the worker publishes finished frames
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    Parameters requested;
+    unsigned requestedGeneration = 0;   // Incremented for every request
+    bool stopping = false;
+    std::atomic<bool> cancel{false};    // Set when the frame in progress is superseded
+    Frame finished;
+    bool frameReady = false;            // finished holds a frame not shown yet
+
+    // Precompute worker: fills the sigma cache at low priority while no
+    // recompute runs, and is cancelled as soon as one starts
+    std::thread precomputer;
+    std::mutex cacheMutex;
+    std::condition_variable precomputeWake;
+    SigmaCache cache;
+    size_t cacheLimit;
+    bool recomputing = false;
+    bool precomputeStopping = false;
+    std::atomic<bool> precomputeCancel{false};
 
     static constexpr int LABEL_HEIGHT = 30;
+    static constexpr int SIGMA_LEVELS = 51;     // Positions of the sigma trackbar
 };
 
 #endif // EDGE_DETECTOR_UI_HPP
\ No newline at end of file
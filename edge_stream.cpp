@@ -0,0 +1,149 @@
+#include "edge_stream.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Streaming pipeline up to non-maximum suppression
+ * Rows are pushed one at a time and suppressed rows are handed to the sink
+ * as soon as their neighbourhood is complete. Memory is bounded by a source
+ * window of one blur chunk plus a kernel radius either side, and rings of
+ * three rows for the blurred image and the gradients, independent of the
+ * image height. The rows match EdgeDetector::suppress with sector encoding.
+ *
+ * @param size Image size
+ * @param type Source row type, one or three channels
+ * @param sigma Standard deviation for Gaussian kernel
+ * @param isColor Flag indicating if the rows have three channels
+ * @param sink Receives the suppressed rows in order
+ */
+EdgeStream::EdgeStream(cv::Size size, int type, double sigma, bool isColor, RowSink sink)
+    : rows(size.height), cols(size.width), isColor(isColor), sigma(sigma),
+      kernelSize(EdgeDetector::calculateGaussianKernelSize(sigma)), radius(kernelSize / 2),
+      chunkRows(std::max(8, kernelSize)), sink(std::move(sink)) {
+    if (rows <= 0 || cols <= 0) {
+        throw std::runtime_error("EdgeStream needs a non-empty image size");
+    }
+    if (CV_MAT_CN(type) != (isColor ? 3 : 1)) {
+        throw std::runtime_error("EdgeStream row type does not match the color mode");
+    }
+
+    window.create(chunkRows + 2 * radius, cols, type);
+    blurred.create(3, cols, CV_MAKETYPE(CV_32F, CV_MAT_CN(type)));
+    magnitude.create(3, cols, CV_32F);
+    sector.create(3, cols, CV_8U);
+    suppressed.create(1, cols, CV_32F);
+}
+
+/**
+ * Append the next source row
+ * @param row Source row, 1 x cols of the stream type
+ */
+void EdgeStream::push(const cv::Mat& row) {
+    if (received == rows) {
+        throw std::runtime_error("EdgeStream received more rows than the image height");
+    }
+    if (row.rows != 1 || row.cols != cols || row.type() != window.type()) {
+        throw std::runtime_error("EdgeStream row does not match the stream format");
+    }
+
+    cv::Mat dst = window.row(windowFill++);
+    row.copyTo(dst);
+    received++;
+
+    // A chunk can be blurred once one radius of rows below it has arrived
+    while (nextBlurred < rows &&
+           received >= std::min(rows, std::min(rows, nextBlurred + chunkRows) + radius)) {
+        blurChunk();
+    }
+}
+
+/**
+ * Blur the next chunk of rows and slide the source window
+ * The window is blurred as an isolated image. It holds one kernel radius
+ * above and below the chunk, or reaches the image border, so the chunk
+ * rows are exactly those of a whole-image blur.
+ */
+void EdgeStream::blurChunk() {
+    int c0 = nextBlurred, c1 = std::min(rows, c0 + chunkRows);
+    int s1 = std::min(rows, c1 + radius);
+
+    cv::GaussianBlur(window.rowRange(0, s1 - windowStart), blurredWindow, cv::Size(kernelSize, kernelSize),
+                     sigma, sigma, cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+
+    for (int y = c0; y < c1; y++) {
+        cv::Mat dst = blurred.row(y % 3);
+        blurredWindow.row(y - windowStart).convertTo(dst, CV_32F);
+        pushBlurred(y);
+    }
+    nextBlurred = c1;
+
+    int keepFrom = std::max(0, c1 - radius);
+    int drop = keepFrom - windowStart;
+    int keep = windowFill - drop;
+    if (keep > 0 && drop > 0) {
+        std::memmove(window.ptr(0), window.ptr(drop), keep * window.step[0]);
+    }
+    windowStart = keepFrom;
+    windowFill = std::max(keep, 0);
+}
+
+/**
+ * Compute the gradient rows that became complete with blurred row y
+ * @param y Image row just written to the blurred ring
+ */
+void EdgeStream::pushBlurred(int y) {
+    auto gradient = [&](int g) {
+        int up = g > 0 ? g - 1 : std::min(1, rows - 1);
+        int down = g + 1 < rows ? g + 1 : std::max(0, rows - 2);
+        EdgeDetector::computeGradientRow(blurred.ptr<float>(up % 3), blurred.ptr<float>(g % 3),
+                                         blurred.ptr<float>(down % 3), cols, isColor,
+                                         magnitude.ptr<float>(g % 3), sector.ptr<uchar>(g % 3));
+        pushGradient(g);
+    };
+
+    if (y >= 1) gradient(y - 1);
+    if (y == rows - 1) gradient(y);
+}
+
+/**
+ * Suppress the rows that became complete with gradient row y
+ * @param y Image row just written to the gradient rings
+ */
+void EdgeStream::pushGradient(int y) {
+    if (y == 0) emitRow(0, false);
+    if (y >= 2) emitRow(y - 1, true);
+    if (y == rows - 1 && y > 0) emitRow(y, false);
+}
+
+/**
+ * Suppress one row and hand it to the sink
+ * @param y Image row
+ * @param interior False for the first and last image rows, which are zero
+ */
+void EdgeStream::emitRow(int y, bool interior) {
+    float* dst = suppressed.ptr<float>(0);
+    if (interior) {
+        EdgeDetector::suppressGradientRow(magnitude.ptr<float>((y - 1) % 3), magnitude.ptr<float>(y % 3),
+                                          magnitude.ptr<float>((y + 1) % 3), sector.ptr<uchar>(y % 3),
+                                          cols, dst);
+        maxValue = std::max(maxValue, *std::max_element(dst, dst + cols));
+    } else {
+        std::fill(dst, dst + cols, 0.f);
+    }
+
+    sink(y, suppressed);
+    emitted++;
+}
+
+/**
+ * Bytes held by the stream's row buffers
+ * @return Buffer bytes, excluding OpenCV's internal filter buffers
+ */
+size_t EdgeStream::bufferBytes() const {
+    size_t total = 0;
+    for (const cv::Mat* mat : {&window, &blurredWindow, &blurred, &magnitude, &sector, &suppressed}) {
+        total += mat->total() * mat->elemSize();
+    }
+    return total;
+}
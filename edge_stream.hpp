@@ -0,0 +1,49 @@
+#ifndef EDGE_STREAM_HPP
+#define EDGE_STREAM_HPP
+
+#include "edge_detector.hpp"
+#include <functional>
+
+// Receives finished rows in order, y from 0 to rows - 1
+using RowSink = std::function<void(int y, const cv::Mat& row)>;
+
+class EdgeStream {
+public:
+    EdgeStream(cv::Size size, int type, double sigma, bool isColor, RowSink sink);
+
+    void push(const cv::Mat& row);
+    bool finished() const { return emitted == rows; }
+    float maxMagnitude() const { return maxValue; }
+    size_t bufferBytes() const;
+
+private:
+    void blurChunk();
+    void pushBlurred(int y);
+    void pushGradient(int y);
+    void emitRow(int y, bool interior);
+
+    int rows;
+    int cols;
+    bool isColor;
+    double sigma;
+    int kernelSize;
+    int radius;
+    int chunkRows;
+    RowSink sink;
+
+    cv::Mat window;         // Source rows, one radius either side of the chunk being blurred
+    cv::Mat blurredWindow;  // Blur output for the window
+    cv::Mat blurred;        // Ring of 3 float blurred rows
+    cv::Mat magnitude;      // Ring of 3 magnitude rows
+    cv::Mat sector;         // Ring of 3 sector rows
+    cv::Mat suppressed;     // Row handed to the sink
+
+    int windowStart = 0;    // Image row held in window row 0
+    int windowFill = 0;
+    int received = 0;
+    int nextBlurred = 0;
+    int emitted = 0;
+    float maxValue = 0;
+};
+
+#endif // EDGE_STREAM_HPP
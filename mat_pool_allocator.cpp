@@ -0,0 +1,188 @@
+#include "mat_pool_allocator.hpp"
+#include <cstdlib>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ * Pooled allocator for Mat buffers
+ * Released buffers are kept by size and handed out again instead of going
+ * back to the system, so repeated frames of similar sizes stop paying for
+ * mmap/munmap and fresh page faults. Buffers are 64-byte aligned; those of
+ * at least one huge page are aligned to it and, on Linux, advised for
+ * transparent huge pages to cut TLB misses on large frames.
+ *
+ * @param maxPooledBytes Idle bytes kept at most; releases beyond go back to the system
+ */
+MatPoolAllocator::MatPoolAllocator(size_t maxPooledBytes) : maxPooledBytes(maxPooledBytes) {}
+
+MatPoolAllocator::~MatPoolAllocator() {
+    trim();
+}
+
+/**
+ * Block size for a request
+ * Powers of two from 4 KB below a huge page, whole huge pages above, so
+ * large frames waste at most one huge page.
+ *
+ * @param bytes Requested bytes
+ * @return Block size
+ */
+size_t MatPoolAllocator::sizeClass(size_t bytes) {
+    if (bytes >= HUGE_PAGE_BYTES) return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+
+    size_t size = 4096;
+    while (size < bytes) size <<= 1;
+    return size;
+}
+
+/**
+ * Take a block from the pool, or allocate one on a miss
+ * The smallest idle block of the size class or up to a quarter larger is
+ * used, so frames whose sizes differ slightly still share blocks.
+ *
+ * @param bytes Requested bytes
+ * @return Aligned block of at least bytes
+ */
+void* MatPoolAllocator::acquire(size_t bytes) const {
+    const size_t size = sizeClass(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idle.lower_bound(size);
+        if (it != idle.end() && it->first <= size + size / 4) {
+            void* data = it->second;
+            counters.hits++;
+            counters.pooledBytes -= it->first;
+            counters.liveBytes += it->first;
+            idle.erase(it);
+            return data;
+        }
+        counters.misses++;
+    }
+
+    bool hugePages = size >= HUGE_PAGE_BYTES;
+    size_t alignment = hugePages ? HUGE_PAGE_BYTES : ALIGNMENT;
+    void* data = nullptr;
+#if defined(_WIN32)
+    data = _aligned_malloc(size, alignment);
+#else
+    if (posix_memalign(&data, alignment, size) != 0) data = nullptr;
+#endif
+    if (!data) throw std::bad_alloc();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (hugePages) madvise(data, size, MADV_HUGEPAGE);
+#else
+    hugePages = false;
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex);
+    blocks[data] = {size, hugePages};
+    counters.liveBytes += size;
+    if (hugePages) counters.hugePageBytes += size;
+    return data;
+}
+
+/**
+ * Return a block to the pool, or to the system when the pool is full
+ * @param data Block from acquire
+ */
+void MatPoolAllocator::recycle(void* data) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = blocks.find(data);
+    CV_Assert(it != blocks.end());
+
+    counters.liveBytes -= it->second.bytes;
+    if (counters.pooledBytes + it->second.bytes > maxPooledBytes) {
+        freeBlock(data, it->second);
+        blocks.erase(it);
+        return;
+    }
+    idle.emplace(it->second.bytes, data);
+    counters.pooledBytes += it->second.bytes;
+}
+
+/**
+ * Give a block back to the system
+ * @param data Block
+ * @param block Its size and huge page flag
+ */
+void MatPoolAllocator::freeBlock(void* data, const Block& block) const {
+    if (block.hugePages) counters.hugePageBytes -= block.bytes;
+#if defined(_WIN32)
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+/**
+ * Release every idle block to the system
+ */
+void MatPoolAllocator::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [bytes, data] : idle) {
+        auto it = blocks.find(data);
+        freeBlock(data, it->second);
+        blocks.erase(it);
+    }
+    idle.clear();
+    counters.pooledBytes = 0;
+}
+
+/**
+ * Snapshot of the pool counters
+ * @return Hits, misses and byte counts
+ */
+MatPoolStats MatPoolAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+/**
+ * Allocate the data of a Mat, laid out like cv::Mat's default allocator
+ * @param dims Number of dimensions
+ * @param sizes Size of each dimension
+ * @param type Element type
+ * @param data User data to wrap instead of allocating, or nullptr
+ * @param step Output steps, or the user steps when data is given
+ * @return UMatData owning the block
+ */
+cv::UMatData* MatPoolAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                         cv::AccessFlag, cv::UMatUsageFlags) const {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar*>(data ? data : acquire(total));
+    u->size = total;
+    if (data) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+}
+
+bool MatPoolAllocator::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+/**
+ * Release the data of a Mat into the pool
+ * @param u UMatData from allocate
+ */
+void MatPoolAllocator::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) recycle(u->origdata);
+    delete u;
+}
@@ -0,0 +1,53 @@
+#ifndef MAT_POOL_ALLOCATOR_HPP
+#define MAT_POOL_ALLOCATOR_HPP
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+struct MatPoolStats {
+    size_t hits = 0;            // Allocations served from an idle block
+    size_t misses = 0;          // Allocations that went to the system
+    size_t pooledBytes = 0;     // Idle bytes kept for reuse
+    size_t liveBytes = 0;       // Bytes held by Mats
+    size_t hugePageBytes = 0;   // Pooled and live bytes advised for transparent huge pages
+};
+
+// cv::MatAllocator that keeps released buffers in size-class pools.
+// Must outlive every Mat it allocated.
+class MatPoolAllocator : public cv::MatAllocator {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+
+    explicit MatPoolAllocator(size_t maxPooledBytes = size_t(1) << 30);
+    ~MatPoolAllocator() override;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    MatPoolStats stats() const;
+    void trim();
+
+private:
+    struct Block {
+        size_t bytes;
+        bool hugePages;
+    };
+
+    static size_t sizeClass(size_t bytes);
+    void* acquire(size_t bytes) const;
+    void recycle(void* data) const;
+    void freeBlock(void* data, const Block& block) const;
+
+    size_t maxPooledBytes;
+    mutable std::mutex mutex;
+    mutable std::multimap<size_t, void*> idle;           // Idle blocks by size
+    mutable std::unordered_map<void*, Block> blocks;     // Every block owned by the pool
+    mutable MatPoolStats counters;
+};
+
+#endif // MAT_POOL_ALLOCATOR_HPP
@@ -0,0 +1,183 @@
+#include "streaming_hysteresis.hpp"
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * Single-pass hysteresis over a stream of suppressed rows
+ * Each row is classified and split into runs of edge pixels. Runs are
+ * joined with the 8-connected runs of the previous row in a union-find
+ * forest, which also records whether a component holds a strong pixel and
+ * the last row it reached. A component that did not reach the newest row
+ * can never grow again, so a buffered row is final once each of its runs
+ * belongs to a strong or a closed component. Rows are emitted in order as
+ * soon as that holds, so latency is bounded by component extent rather
+ * than image height.
+ *
+ * Thresholds are absolute: the maximum of a stream is not known until its
+ * last row. The edges match EdgeDetector::applyThresholding with
+ * ThresholdMode::Absolute.
+ *
+ * @param size Image size
+ * @param lowThreshold Absolute low threshold
+ * @param highThreshold Absolute high threshold
+ * @param sink Receives the CV_8U edge rows (0 / EDGE_STRONG) in order
+ */
+StreamingHysteresis::StreamingHysteresis(cv::Size size, float lowThreshold, float highThreshold, RowSink sink)
+    : rows(size.height), cols(size.width), lowThreshold(lowThreshold), highThreshold(highThreshold),
+      sink(std::move(sink)), edges(1, size.width, CV_8U) {
+    if (rows <= 0 || cols <= 0) {
+        throw std::runtime_error("StreamingHysteresis needs a non-empty image size");
+    }
+}
+
+/**
+ * Root of a run id, with path halving
+ * @param id Run id
+ * @return Root id
+ */
+int StreamingHysteresis::find(int id) {
+    while (parent[id] != id) {
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+/**
+ * Merge the components of two runs
+ * @param a Run id
+ * @param b Run id
+ */
+void StreamingHysteresis::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (b < a) std::swap(a, b);
+
+    parent[b] = a;
+    strong[a] = strong[a] || strong[b];
+    lastRow[a] = std::max(lastRow[a], lastRow[b]);
+}
+
+/**
+ * Whether every run of a buffered row has a final label
+ * @param row Buffered row
+ * @return True when the row can be emitted
+ */
+bool StreamingHysteresis::resolved(const Row& row) {
+    if (received == rows) return true;
+
+    for (const Run& run : row.runs) {
+        int root = find(run.id);
+        if (!strong[root] && lastRow[root] == received - 1) return false;
+    }
+    return true;
+}
+
+/**
+ * Append the next suppressed row
+ * @param suppressed CV_32F row of non-maximum suppression output
+ */
+void StreamingHysteresis::push(const cv::Mat& suppressed) {
+    if (received == rows) {
+        throw std::runtime_error("StreamingHysteresis received more rows than the image height");
+    }
+    if (suppressed.rows != 1 || suppressed.cols != cols || suppressed.type() != CV_32F) {
+        throw std::runtime_error("StreamingHysteresis row does not match the stream format");
+    }
+
+    // Runs of strong and weak pixels; weak pixels only away from the image border
+    const int y = received;
+    const float* src = suppressed.ptr<float>(0);
+    const bool interiorRow = y > 0 && y < rows - 1;
+    Row row{y, {}};
+
+    for (int x = 0; x < cols; x++) {
+        bool isStrong = src[x] >= highThreshold;
+        bool isWeak = !isStrong && src[x] >= lowThreshold && interiorRow && x > 0 && x < cols - 1;
+        if (!isStrong && !isWeak) continue;
+
+        if (row.runs.empty() || row.runs.back().x1 != x - 1) {
+            int id = static_cast<int>(parent.size());
+            row.runs.push_back({x, x, id});
+            parent.push_back(id);
+            strong.push_back(0);
+            lastRow.push_back(y);
+        }
+        row.runs.back().x1 = x;
+        if (isStrong) strong[row.runs.back().id] = 1;
+    }
+
+    // Join runs that touch, including diagonally, a run of the previous row
+    size_t i = 0, j = 0;
+    while (i < row.runs.size() && j < previous.size()) {
+        const Run& run = row.runs[i];
+        const Run& above = previous[j];
+        if (above.x0 <= run.x1 + 1 && above.x1 >= run.x0 - 1) unite(run.id, above.id);
+        if (above.x1 < run.x1) j++;
+        else i++;
+    }
+
+    previous = row.runs;
+    bufferedRuns += row.runs.size();
+    pending.push_back(std::move(row));
+    received++;
+    maxPending = std::max(maxPending, static_cast<int>(pending.size()));
+
+    emitReady();
+    // Compact once the forest has grown since the last compaction by more
+    // runs than a compaction visits, so each one is paid for by new runs
+    size_t grown = parent.size() - compactedSize;
+    if (grown > std::max<size_t>(1024, bufferedRuns + previous.size())) compact();
+}
+
+/**
+ * Emit buffered rows from the front of the queue while they are final
+ */
+void StreamingHysteresis::emitReady() {
+    while (!pending.empty() && resolved(pending.front())) {
+        const Row& row = pending.front();
+        uchar* dst = edges.ptr<uchar>(0);
+        std::fill(dst, dst + cols, 0);
+        for (const Run& run : row.runs) {
+            if (strong[find(run.id)]) std::fill(dst + run.x0, dst + run.x1 + 1, EdgeDetector::EDGE_STRONG);
+        }
+
+        sink(row.y, edges);
+        emitted++;
+        bufferedRuns -= row.runs.size();
+        pending.pop_front();
+    }
+}
+
+/**
+ * Renumber the live runs so the forest only holds components that can
+ * still be referenced: those of buffered rows and of the previous row
+ */
+void StreamingHysteresis::compact() {
+    std::unordered_map<int, int> remap;
+    std::vector<int> newParent;
+    std::vector<char> newStrong;
+    std::vector<int> newLastRow;
+
+    auto relabel = [&](Run& run) {
+        int root = find(run.id);
+        auto [it, inserted] = remap.emplace(root, static_cast<int>(newParent.size()));
+        if (inserted) {
+            newParent.push_back(it->second);
+            newStrong.push_back(strong[root]);
+            newLastRow.push_back(lastRow[root]);
+        }
+        run.id = it->second;
+    };
+
+    for (Row& row : pending) {
+        for (Run& run : row.runs) relabel(run);
+    }
+    for (Run& run : previous) relabel(run);
+
+    parent = std::move(newParent);
+    strong = std::move(newStrong);
+    lastRow = std::move(newLastRow);
+    compactedSize = parent.size();
+}
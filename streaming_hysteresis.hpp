@@ -0,0 +1,56 @@
+#ifndef STREAMING_HYSTERESIS_HPP
+#define STREAMING_HYSTERESIS_HPP
+
+#include "edge_stream.hpp"
+#include <deque>
+#include <vector>
+
+class StreamingHysteresis {
+public:
+    StreamingHysteresis(cv::Size size, float lowThreshold, float highThreshold, RowSink sink);
+
+    void push(const cv::Mat& suppressed);
+    bool finished() const { return emitted == rows; }
+    int pendingRows() const { return static_cast<int>(pending.size()); }
+    int maxPendingRows() const { return maxPending; }
+
+private:
+    struct Run {
+        int x0;
+        int x1;     // Inclusive
+        int id;
+    };
+
+    struct Row {
+        int y;
+        std::vector<Run> runs;
+    };
+
+    int find(int id);
+    void unite(int a, int b);
+    bool resolved(const Row& row);
+    void emitReady();
+    void compact();
+
+    int rows;
+    int cols;
+    float lowThreshold;
+    float highThreshold;
+    RowSink sink;
+
+    std::vector<int> parent;     // Union-find forest over run ids
+    std::vector<char> strong;    // Per root: component holds a strong pixel
+    std::vector<int> lastRow;    // Per root: last row with a run of the component
+    size_t compactedSize = 0;    // Forest size after the last compaction
+
+    std::deque<Row> pending;     // Rows waiting for their components to resolve
+    size_t bufferedRuns = 0;     // Runs of the pending rows
+    std::vector<Run> previous;   // Runs of the last pushed row
+    cv::Mat edges;               // Row handed to the sink
+
+    int received = 0;
+    int emitted = 0;
+    int maxPending = 0;
+};
+
+#endif // STREAMING_HYSTERESIS_HPP
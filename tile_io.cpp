@@ -0,0 +1,149 @@
+#include "tile_io.hpp"
+#include <cctype>
+#include <stdexcept>
+
+/**
+ * Read the next header token of a PNM file, skipping whitespace and comments
+ * @param in Input stream positioned inside the header
+ * @return Token text
+ */
+std::string pnmToken(std::istream& in) {
+    std::string token;
+    int c;
+    while ((c = in.get()) != EOF) {
+        if (c == '#') {
+            while ((c = in.get()) != EOF && c != '\n') {}
+        } else if (!std::isspace(c)) {
+            token += static_cast<char>(c);
+            break;
+        }
+    }
+    while ((c = in.peek()) != EOF && !std::isspace(c) && c != '#') {
+        token += static_cast<char>(in.get());
+    }
+    return token;
+}
+
+/**
+ * Open a raster file
+ * @param path File path
+ * @param size Image size
+ * @param type Pixel type
+ * @param offset Byte offset of the first pixel
+ * @param create Create or truncate the file and open it for writing
+ * @param rgb Channels are stored as RGB
+ */
+RasterFile::RasterFile(const std::string& path, cv::Size size, int type, std::streamoff offset, bool create,
+                       bool rgb)
+    : path(path), imageSize(size), imageType(type), dataOffset(offset), rgb(rgb) {
+    auto mode = std::ios::in | std::ios::binary;
+    if (create) mode |= std::ios::out | std::ios::trunc;
+    file.open(path, mode);
+    if (!file) {
+        throw std::runtime_error("Could not open raster file: " + path);
+    }
+}
+
+/**
+ * Open an 8-bit binary PGM (P5) or PPM (P6) image for tiled reading
+ * @param path File path
+ * @return Raster with CV_8UC1 or CV_8UC3 (BGR) pixels
+ */
+std::unique_ptr<RasterFile> RasterFile::openPnm(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open or find the image: " + path);
+    }
+
+    std::string magic = pnmToken(in);
+    if (magic != "P5" && magic != "P6") {
+        throw std::runtime_error("Not a binary PGM/PPM image: " + path);
+    }
+    int width = std::stoi(pnmToken(in));
+    int height = std::stoi(pnmToken(in));
+    int maxValue = std::stoi(pnmToken(in));
+    if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255) {
+        throw std::runtime_error("Unsupported PGM/PPM header: " + path);
+    }
+    in.get();
+
+    bool color = magic == "P6";
+    return std::unique_ptr<RasterFile>(new RasterFile(path, cv::Size(width, height), color ? CV_8UC3 : CV_8UC1,
+                                                      in.tellg(), false, color));
+}
+
+/**
+ * Create an 8-bit binary PGM or PPM image to be written tile by tile
+ * @param path File path
+ * @param size Image size
+ * @param type CV_8UC1 or CV_8UC3 (BGR)
+ * @return Raster covering the whole image
+ */
+std::unique_ptr<RasterFile> RasterFile::createPnm(const std::string& path, cv::Size size, int type) {
+    if (type != CV_8UC1 && type != CV_8UC3) {
+        throw std::runtime_error("PGM/PPM output must be CV_8UC1 or CV_8UC3");
+    }
+
+    bool color = type == CV_8UC3;
+    std::string header = std::string(color ? "P6" : "P5") + "\n" + std::to_string(size.width) + " " +
+                         std::to_string(size.height) + "\n255\n";
+    std::unique_ptr<RasterFile> raster(new RasterFile(path, size, type, header.size(), true, color));
+    raster->file.write(header.data(), header.size());
+    return raster;
+}
+
+/**
+ * Create a headerless scratch raster
+ * @param path File path
+ * @param size Image size
+ * @param type Pixel type
+ * @return Raster covering the whole image
+ */
+std::unique_ptr<RasterFile> RasterFile::createScratch(const std::string& path, cv::Size size, int type) {
+    return std::unique_ptr<RasterFile>(new RasterFile(path, size, type, 0, true, false));
+}
+
+/**
+ * Read a region of the raster
+ * @param region Region inside the image
+ * @return Pixels of the region
+ */
+cv::Mat RasterFile::read(const cv::Rect& region) {
+    cv::Mat tile(region.size(), imageType);
+    const std::streamoff elemSize = tile.elemSize();
+
+    for (int y = 0; y < region.height; y++) {
+        file.seekg(dataOffset + (static_cast<std::streamoff>(region.y + y) * imageSize.width + region.x) * elemSize);
+        file.read(reinterpret_cast<char*>(tile.ptr(y)), region.width * elemSize);
+        if (!file) {
+            throw std::runtime_error("Could not read raster file: " + path);
+        }
+    }
+
+    if (rgb) cv::cvtColor(tile, tile, cv::COLOR_RGB2BGR);
+    return tile;
+}
+
+/**
+ * Write a region of the raster
+ * @param region Region inside the image
+ * @param tile Pixels of the region
+ */
+void RasterFile::write(const cv::Rect& region, const cv::Mat& tile) {
+    if (tile.size() != region.size() || tile.type() != imageType) {
+        throw std::runtime_error("Tile does not match the raster region: " + path);
+    }
+
+    cv::Mat pixels;
+    if (rgb) cv::cvtColor(tile, pixels, cv::COLOR_BGR2RGB);
+    else pixels = tile;
+    const std::streamoff elemSize = pixels.elemSize();
+
+    for (int y = 0; y < region.height; y++) {
+        file.seekp(dataOffset + (static_cast<std::streamoff>(region.y + y) * imageSize.width + region.x) * elemSize);
+        file.write(reinterpret_cast<const char*>(pixels.ptr(y)), region.width * elemSize);
+        if (!file) {
+            throw std::runtime_error("Could not write raster file: " + path);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TILE_IO_HPP
+#define TILE_IO_HPP
+
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+
+class TileReader {
+public:
+    virtual ~TileReader() = default;
+    virtual cv::Size size() const = 0;
+    virtual int type() const = 0;
+    virtual cv::Mat read(const cv::Rect& region) = 0;
+};
+
+class TileWriter {
+public:
+    virtual ~TileWriter() = default;
+    virtual void write(const cv::Rect& region, const cv::Mat& tile) = 0;
+};
+
+// Uncompressed raster on disk, accessed region by region with seeks
+class RasterFile : public TileReader, public TileWriter {
+public:
+    static std::unique_ptr<RasterFile> openPnm(const std::string& path);
+    static std::unique_ptr<RasterFile> createPnm(const std::string& path, cv::Size size, int type);
+    static std::unique_ptr<RasterFile> createScratch(const std::string& path, cv::Size size, int type);
+
+    cv::Size size() const override { return imageSize; }
+    int type() const override { return imageType; }
+    cv::Mat read(const cv::Rect& region) override;
+    void write(const cv::Rect& region, const cv::Mat& tile) override;
+
+private:
+    RasterFile(const std::string& path, cv::Size size, int type, std::streamoff offset, bool create, bool rgb);
+
+    std::fstream file;
+    std::string path;
+    cv::Size imageSize;
+    int imageType;
+    std::streamoff dataOffset;
+    bool rgb;               // Channels stored as RGB, swapped to BGR in memory
+};
+
+#endif // TILE_IO_HPP
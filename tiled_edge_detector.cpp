@@ -0,0 +1,218 @@
+#include "tiled_edge_detector.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+/**
+ * Scratch files of one run, deleted when the run ends
+ */
+struct ScratchFiles {
+    fs::path suppressed;
+    fs::path labels;
+
+    ~ScratchFiles() {
+        std::error_code ignored;
+        fs::remove(suppressed, ignored);
+        fs::remove(labels, ignored);
+    }
+};
+
+/**
+ * Grow a rectangle on every side, clipped to the image
+ * @param rect Rectangle
+ * @param by Pixels to add on each side
+ * @param image Image bounds
+ * @return Grown rectangle
+ */
+cv::Rect growRect(const cv::Rect& rect, int by, const cv::Rect& image) {
+    return cv::Rect(rect.x - by, rect.y - by, rect.width + 2 * by, rect.height + 2 * by) & image;
+}
+
+/**
+ * Double thresholding of one tile
+ * Each row goes through EdgeDetector::classifyRow with the border flags of
+ * the tile in the whole image, so weak pixels are kept only away from the
+ * image border, as in EdgeDetector::classifyEdges.
+ *
+ * @param suppressed Suppressed magnitudes of the tile
+ * @param core Tile rectangle in the image
+ * @param size Image size
+ * @param lowThr Absolute low threshold
+ * @param highThr Absolute high threshold
+ * @return Label map of the tile (0 / EDGE_WEAK / EDGE_STRONG)
+ */
+cv::Mat classifyTile(const cv::Mat& suppressed, const cv::Rect& core, cv::Size size, float lowThr, float highThr) {
+    cv::Mat labels(core.size(), CV_8U);
+    bool leftBorder = core.x == 0;
+    bool rightBorder = core.x + core.width == size.width;
+    for (int y = 0; y < core.height; y++) {
+        int gy = core.y + y;
+        EdgeDetector::classifyRow(suppressed.ptr<float>(y), core.width, lowThr, highThr,
+                                  gy > 0 && gy < size.height - 1, labels.ptr<uchar>(y), leftBorder, rightBorder);
+    }
+    return labels;
+}
+
+/**
+ * Promote the weak pixels of a tile connected to a strong pixel
+ * Seeds are the strong pixels of the tile and of its one pixel halo, which
+ * holds the latest labels of the neighbouring tiles. Only pixels inside the
+ * core are promoted; weak pixels that stay weak may still be reached from
+ * another tile later, so they are not cleared here.
+ *
+ * @param labels Label map of the core and its halo, updated in place
+ * @param core Core rectangle inside labels
+ * @param reachedBorder Set when a pixel on the outer ring of the core was promoted
+ * @return Number of promoted pixels
+ */
+int TiledEdgeDetector::promoteTile(cv::Mat& labels, const cv::Rect& core, bool& reachedBorder) {
+    static constexpr int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    static constexpr int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+    const int x0 = core.x, y0 = core.y, x1 = core.x + core.width, y1 = core.y + core.height;
+    std::vector<cv::Point> stack;
+    int promoted = 0;
+
+    for (int y = 0; y < labels.rows; y++) {
+        const uchar* row = labels.ptr<uchar>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            if (row[x] == EdgeDetector::EDGE_STRONG) stack.emplace_back(x, y);
+        }
+    }
+
+    while (!stack.empty()) {
+        cv::Point p = stack.back();
+        stack.pop_back();
+
+        for (int i = 0; i < 8; i++) {
+            int nx = p.x + dx[i];
+            int ny = p.y + dy[i];
+            if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1) continue;
+
+            uchar& neighbour = labels.at<uchar>(ny, nx);
+            if (neighbour == EdgeDetector::EDGE_WEAK) {
+                neighbour = EdgeDetector::EDGE_STRONG;
+                stack.emplace_back(nx, ny);
+                promoted++;
+                if (nx == x0 || ny == y0 || nx == x1 - 1 || ny == y1 - 1) reachedBorder = true;
+            }
+        }
+    }
+    return promoted;
+}
+
+/**
+ * Out-of-core Canny edge detection
+ * 1. Blur, gradients and non-maximum suppression per tile. Each tile is
+ *    read with a halo of one kernel radius plus two pixels, so its core
+ *    matches the whole-image result exactly. Suppressed cores go to a
+ *    scratch file and the maximum is tracked.
+ * 2. Double thresholding of each core against that maximum into a label
+ *    scratch file. With absolute thresholds there is no maximum to wait
+ *    for: cores are classified in step 1 and no suppressed file is kept.
+ * 3. Edge tracking tile by tile. A tile whose promoted edges reach its
+ *    border marks its neighbours, and sweeps repeat until no tile changes.
+ * 4. Weak pixels that were never reached are cleared and the edge map is
+ *    written tile by tile.
+ * Memory is bounded by one tile with its halo and the pipeline
+ * intermediates for it, whatever the image size.
+ *
+ * @param reader Source image, one or three channels, converted per tile to match params.isColor
+ * @param writer Receives the CV_8U edge map tile by tile
+ * @param params TiledParams containing thresholds, tile size and scratch location
+ * @return Tile and edge tracking counters
+ */
+TiledStats TiledEdgeDetector::process(TileReader& reader, TileWriter& writer, const TiledParams& params) {
+    const cv::Size size = reader.size();
+    const cv::Rect image(0, 0, size.width, size.height);
+    const int tileSize = std::max(1, params.tileSize);
+    const int halo = EdgeDetector::calculateGaussianKernelSize(params.sigma) / 2 + 2;
+    const int tilesX = (size.width + tileSize - 1) / tileSize;
+    const int tilesY = (size.height + tileSize - 1) / tileSize;
+
+    auto coreOf = [&](int tile) {
+        return cv::Rect((tile % tilesX) * tileSize, (tile / tilesX) * tileSize, tileSize, tileSize) & image;
+    };
+    auto inside = [](const cv::Rect& region, const cv::Rect& outer) {
+        return cv::Rect(region.x - outer.x, region.y - outer.y, region.width, region.height);
+    };
+
+    TiledStats stats;
+    stats.tiles = tilesX * tilesY;
+
+    fs::path directory = params.scratchDirectory.empty() ? fs::temp_directory_path()
+                                                         : fs::path(params.scratchDirectory);
+    std::string stem = "edges-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    ScratchFiles scratch{directory / (stem + ".suppressed"), directory / (stem + ".labels")};
+    const bool relative = params.thresholdMode == ThresholdMode::Relative;
+    auto suppressedFile = relative ? RasterFile::createScratch(scratch.suppressed.string(), size, CV_32F) : nullptr;
+    auto labelFile = RasterFile::createScratch(scratch.labels.string(), size, CV_8U);
+
+    EdgeWorkspace workspace;
+    float maxVal = 0;
+    for (int tile = 0; tile < stats.tiles; tile++) {
+        cv::Rect core = coreOf(tile), region = growRect(core, halo, image);
+        cv::Mat source = reader.read(region);
+        if (!params.isColor && source.channels() == 3) cv::cvtColor(source, source, cv::COLOR_BGR2GRAY);
+        if (params.isColor && source.channels() == 1) cv::cvtColor(source, source, cv::COLOR_GRAY2BGR);
+
+        GradientParams tileParams;
+        tileParams.source = source;
+        tileParams.sigma = params.sigma;
+        tileParams.lowThreshold = params.lowThreshold;
+        tileParams.highThreshold = params.highThreshold;
+        tileParams.isColor = params.isColor;
+        tileParams.stripes = params.stripes;
+        cv::Mat suppressed = EdgeDetector::suppress(tileParams, workspace)(inside(core, region));
+        if (!relative) {
+            labelFile->write(core, classifyTile(suppressed, core, size, params.lowThreshold, params.highThreshold));
+            continue;
+        }
+
+        double tileMax;
+        cv::minMaxLoc(suppressed, nullptr, &tileMax);
+        maxVal = std::max(maxVal, static_cast<float>(tileMax));
+        suppressedFile->write(core, suppressed);
+    }
+
+    float highThr = params.highThreshold * maxVal;
+    float lowThr = params.lowThreshold * maxVal;
+    for (int tile = 0; relative && tile < stats.tiles; tile++) {
+        cv::Rect core = coreOf(tile);
+        labelFile->write(core, classifyTile(suppressedFile->read(core), core, size, lowThr, highThr));
+    }
+
+    std::vector<char> dirty(stats.tiles, 1);
+    while (std::find(dirty.begin(), dirty.end(), 1) != dirty.end()) {
+        stats.hysteresisSweeps++;
+        for (int tile = 0; tile < stats.tiles; tile++) {
+            if (!dirty[tile]) continue;
+            dirty[tile] = 0;
+            stats.tileVisits++;
+
+            cv::Rect core = coreOf(tile), region = growRect(core, 1, image);
+            cv::Mat labels = labelFile->read(region);
+            bool reachedBorder = false;
+            if (promoteTile(labels, inside(core, region), reachedBorder) == 0) continue;
+            labelFile->write(core, labels(inside(core, region)));
+
+            if (!reachedBorder) continue;
+            int tx = tile % tilesX, ty = tile / tilesX;
+            for (int ny = std::max(0, ty - 1); ny <= std::min(tilesY - 1, ty + 1); ny++) {
+                for (int nx = std::max(0, tx - 1); nx <= std::min(tilesX - 1, tx + 1); nx++) {
+                    if (nx != tx || ny != ty) dirty[ny * tilesX + nx] = 1;
+                }
+            }
+        }
+    }
+
+    for (int tile = 0; tile < stats.tiles; tile++) {
+        cv::Rect core = coreOf(tile);
+        cv::Mat labels = labelFile->read(core);
+        labels.setTo(0, labels == EdgeDetector::EDGE_WEAK);
+        writer.write(core, labels);
+    }
+    return stats;
+}
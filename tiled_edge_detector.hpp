@@ -0,0 +1,32 @@
+#ifndef TILED_EDGE_DETECTOR_HPP
+#define TILED_EDGE_DETECTOR_HPP
+
+#include "edge_detector.hpp"
+#include "tile_io.hpp"
+
+struct TiledParams {
+    double sigma;
+    float lowThreshold;
+    float highThreshold;
+    bool isColor;
+    ThresholdMode thresholdMode = ThresholdMode::Relative;
+    int tileSize = 1024;            // Core tile width and height, bounds peak memory
+    std::string scratchDirectory;   // Suppressed and label scratch files, empty = system temp
+    int stripes = 0;                // Row stripes inside each tile, 0 = one per OpenCV thread
+};
+
+struct TiledStats {
+    int tiles = 0;
+    int hysteresisSweeps = 0;       // Passes over the dirty tiles until no edge crossed a border
+    int tileVisits = 0;             // Tile loads during edge tracking
+};
+
+class TiledEdgeDetector {
+public:
+    static TiledStats process(TileReader& reader, TileWriter& writer, const TiledParams& params);
+
+private:
+    static int promoteTile(cv::Mat& labels, const cv::Rect& core, bool& reachedBorder);
+};
+
+#endif // TILED_EDGE_DETECTOR_HPP
@@ -0,0 +1,292 @@
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <chrono>
+
+// Pool and worker index of the calling thread, unset outside any pool
+static thread_local WorkerPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+/**
+ * Seconds elapsed since a point in time
+ * @param start Start of the interval
+ * @return Elapsed seconds
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Start the worker threads
+ * @param threads Number of workers, 0 for one per OpenCV thread
+ */
+WorkerPool::WorkerPool(int threads) {
+    workerCount = threads > 0 ? threads : std::max(1, cv::getNumThreads());
+    workers.reset(new Worker[workerCount]);
+    for (int worker = 0; worker < workerCount; worker++) {
+        this->threads.emplace_back(&WorkerPool::work, this, worker);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+/**
+ * Pool shared by the batch entry points, started on first use
+ * @return Process-wide pool
+ */
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+/**
+ * Pool whose worker is calling, so nested work can fork onto its deque
+ * @return Pool of the calling worker, nullptr on any other thread
+ */
+WorkerPool* WorkerPool::current() {
+    return currentPool;
+}
+
+/**
+ * Run task(index, worker) for every index in [0, count) and wait for all
+ * of them. Called from outside the pool, the indices are dealt round-robin
+ * to the worker deques, lowest index on top, and workers steal from each
+ * other as they run dry. Called from a task of this pool, the indices are
+ * forked onto the calling worker's deque instead. The first exception
+ * thrown by a task is rethrown here once the batch has drained; indices
+ * not started by then are skipped.
+ *
+ * @param count Number of tasks
+ * @param task Task body; worker is in [0, size()) and stable for the thread
+ * @param stats Optional; receives the wall time and per-worker counters of a run from outside the pool
+ */
+void WorkerPool::run(int count, const Task& task, PoolStats* stats) {
+    if (count <= 0) return;
+    if (currentPool == this) {
+        forkJoin(count, task, currentWorker);
+        return;
+    }
+
+    std::lock_guard<std::mutex> batch(batchMutex);
+    for (int worker = 0; worker < workerCount; worker++) workers[worker].stats = WorkerStats();
+    auto start = std::chrono::steady_clock::now();
+
+    Join join;
+    join.pending.store(count, std::memory_order_relaxed);
+    for (int index = count - 1; index >= 0; index--) push(index % workerCount, Job{&task, index, &join});
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_all();
+    wait(join);
+
+    // Still under batchMutex, so no other run resets the counters meanwhile
+    if (stats) {
+        stats->seconds = secondsSince(start);
+        stats->workers.clear();
+        for (int worker = 0; worker < workerCount; worker++) stats->workers.push_back(workers[worker].stats);
+    }
+    if (join.error) std::rethrow_exception(join.error);
+}
+
+/**
+ * Split a range into stripes and run body on each of them as pool tasks
+ * Mirrors cv::parallel_for_: the range is cut into stripes near-equal
+ * parts. From a worker of this pool the stripes go onto its own deque,
+ * where idle workers can steal them while the caller works through the
+ * rest; a stripe count of one runs inline.
+ *
+ * @param range Range to split
+ * @param body Called once per stripe with its sub-range
+ * @param stripes Number of parts
+ */
+void WorkerPool::parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, int stripes) {
+    int length = range.size();
+    int count = std::max(1, std::min(stripes, length));
+    if (count == 1) {
+        if (length > 0) body(range);
+        return;
+    }
+
+    // A task capturing a single reference fits in std::function's inline
+    // buffer, so forking the stripes does not allocate
+    struct Split {
+        const cv::Range& range;
+        const cv::ParallelLoopBody& body;
+        int length;
+        int count;
+    } split{range, body, length, count};
+
+    run(count, [&split](int index, int) {
+        int start = split.range.start + static_cast<int>(static_cast<int64_t>(split.length) * index / split.count);
+        int end = split.range.start + static_cast<int>(static_cast<int64_t>(split.length) * (index + 1) / split.count);
+        split.body(cv::Range(start, end));
+    });
+}
+
+/**
+ * Push a job on top of a worker's deque; the caller wakes the workers
+ * @param worker Owner of the deque
+ * @param job Job to queue
+ */
+void WorkerPool::push(int worker, const Job& job) {
+    std::lock_guard<std::mutex> lock(workers[worker].mutex);
+    workers[worker].jobs.push_back(job);
+    queued.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Take the newest job of the worker's own deque, or else steal the oldest
+ * job of the next non-empty deque
+ * @param worker Calling worker
+ * @param job Receives the job
+ * @return False when every deque is empty
+ */
+bool WorkerPool::take(int worker, Job& job) {
+    if (queued.load(std::memory_order_acquire) == 0) return false;
+
+    Worker& self = workers[worker];
+    {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.jobs.empty()) {
+            job = self.jobs.back();
+            self.jobs.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    for (int offset = 1; offset < workerCount; offset++) {
+        Worker& victim = workers[(worker + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            self.stats.steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Take the newest job of a join from the worker's own deque, where forkJoin
+ * put all of them; jobs of other joins below are left for later
+ * @param worker Calling worker
+ * @param join Join whose jobs to take
+ * @param job Receives the job
+ * @return False when no job of the join is left in the deque
+ */
+bool WorkerPool::takeOwn(int worker, const Join& join, Job& job) {
+    Worker& self = workers[worker];
+    std::lock_guard<std::mutex> lock(self.mutex);
+    for (auto it = self.jobs.rbegin(); it != self.jobs.rend(); ++it) {
+        if (it->join != &join) continue;
+        job = *it;
+        self.jobs.erase(std::next(it).base());
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Block until every job of a join has finished
+ * @param join Join to wait for
+ */
+void WorkerPool::wait(Join& join) {
+    std::unique_lock<std::mutex> lock(join.mutex);
+    join.finished.wait(lock, [&] { return join.pending.load(std::memory_order_acquire) == 0; });
+}
+
+/**
+ * Run a job and count it towards its join
+ * The counters are updated before the join is released, so they are
+ * complete when the run that owns the job returns.
+ *
+ * @param job Job to run
+ * @param worker Calling worker
+ * @param topLevel Whether the job was taken by the worker loop rather than while helping a join
+ */
+void WorkerPool::execute(const Job& job, int worker, bool topLevel) {
+    WorkerStats& stats = workers[worker].stats;
+    Join& join = *job.join;
+    auto start = std::chrono::steady_clock::now();
+
+    if (!join.failed.load(std::memory_order_relaxed)) {
+        try {
+            (*job.task)(job.index, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(join.mutex);
+            if (!join.error) join.error = std::current_exception();
+            join.failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    if (topLevel) stats.busySeconds += secondsSince(start);
+    stats.tasks++;
+
+    // The waiter may destroy the join as soon as it sees the count reach
+    // zero, which it only checks under the join's mutex
+    std::lock_guard<std::mutex> lock(join.mutex);
+    if (join.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) join.finished.notify_all();
+}
+
+/**
+ * Fork tasks onto a worker's deque and help until all of them are done
+ * The worker runs the jobs of this join newest first, so it starts at
+ * index 0, while idle workers steal the oldest ones. It never picks up an
+ * unrelated job here, so a whole image dealt to it cannot run nested in
+ * the barrier of another. Once the rest of the join runs elsewhere it
+ * blocks until those jobs finish; that time is not counted as busy.
+ *
+ * @param count Number of tasks
+ * @param task Task body
+ * @param worker Calling worker
+ */
+void WorkerPool::forkJoin(int count, const Task& task, int worker) {
+    Join join;
+    join.pending.store(count, std::memory_order_relaxed);
+    for (int index = count - 1; index >= 0; index--) push(worker, Job{&task, index, &join});
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_all();
+
+    Job job;
+    while (takeOwn(worker, join, job)) execute(job, worker, false);
+
+    auto start = std::chrono::steady_clock::now();
+    wait(join);
+    workers[worker].stats.busySeconds -= secondsSince(start);
+
+    if (join.error) std::rethrow_exception(join.error);
+}
+
+/**
+ * Worker loop: run and steal jobs, sleep while every deque is empty
+ * @param worker Index of this worker
+ */
+void WorkerPool::work(int worker) {
+    currentPool = this;
+    currentWorker = worker;
+
+    Job job;
+    while (true) {
+        if (take(worker, job)) {
+            execute(job, worker, true);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
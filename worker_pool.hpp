@@ -0,0 +1,83 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerStats {
+    double busySeconds = 0;     // Running tasks, not counting waits for stripes run elsewhere
+    int tasks = 0;              // Tasks run, stripes included
+    int steals = 0;             // Tasks taken from another worker's deque
+};
+
+struct PoolStats {
+    double seconds = 0;         // Wall time of the batch
+    std::vector<WorkerStats> workers;
+};
+
+// Persistent threads with one work-stealing deque each. A worker runs the
+// newest task of its own deque and steals the oldest task of another one
+// when it runs dry. Tasks may fork stripes with parallelFor, which idle
+// workers steal while the forking worker runs the rest of them.
+class WorkerPool {
+public:
+    using Task = std::function<void(int index, int worker)>;
+
+    explicit WorkerPool(int threads = 0);
+    ~WorkerPool();
+
+    int size() const { return workerCount; }
+    void run(int count, const Task& task, PoolStats* stats = nullptr);
+    void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, int stripes);
+
+    static WorkerPool& shared();
+    static WorkerPool* current();
+
+private:
+    struct Join {
+        std::atomic<int> pending{0};    // Jobs not finished yet
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::condition_variable finished;   // pending reached zero
+        std::exception_ptr error;       // First exception thrown by a job of the join
+    };
+
+    struct Job {
+        const Task* task;
+        int index;
+        Join* join;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        WorkerStats stats;
+    };
+
+    void work(int worker);
+    void push(int worker, const Job& job);
+    bool take(int worker, Job& job);
+    bool takeOwn(int worker, const Join& join, Job& job);
+    void wait(Join& join);
+    void execute(const Job& job, int worker, bool topLevel);
+    void forkJoin(int count, const Task& task, int worker);
+
+    int workerCount = 0;
+    std::vector<std::thread> threads;
+    std::unique_ptr<Worker[]> workers;
+    std::atomic<int> queued{0};         // Jobs waiting in any deque
+    std::mutex batchMutex;              // Serialises run from outside the pool
+    std::mutex mutex;
+    std::condition_variable wake;       // Jobs were queued, or the pool stops
+    bool stopping = false;
+};
+
+#endif // WORKER_POOL_HPP